@@ -23,7 +23,7 @@ fi
 echo "Checking dependencies..."
 
 # Check for Qt6
-if ! pkg-config --exists Qt6Core Qt6Widgets Qt6Gui; then
+if ! pkg-config --exists Qt6Core Qt6Widgets Qt6Gui Qt6Concurrent Qt6Network; then
     echo "Error: Qt6 development libraries not found."
     echo "Please install Qt6 development packages:"
     echo "  Ubuntu/Debian: sudo apt install qt6-base-dev"
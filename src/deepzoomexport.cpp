@@ -0,0 +1,445 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#include "deepzoomexport.h"
+#include "imageloader.h"
+#include "resampler.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QFuture>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QVector>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Level 0 is a single pixel, the last level is the full image
+int maxLevelFor(const QSize &size)
+{
+    const int longest = qMax(size.width(), size.height());
+    return static_cast<int>(std::ceil(std::log2(static_cast<double>(longest))));
+}
+
+QSize levelSize(const QSize &size, int maxLevel, int level)
+{
+    const double divisor = std::ldexp(1.0, maxLevel - level);
+    return QSize(qMax(1, static_cast<int>(std::ceil(size.width() / divisor))),
+                 qMax(1, static_cast<int>(std::ceil(size.height() / divisor))));
+}
+
+QRect tileRect(int column, int row, const DeepZoomExport::Options &options)
+{
+    const int left = column * options.tileSize - (column > 0 ? options.overlap : 0);
+    const int top = row * options.tileSize - (row > 0 ? options.overlap : 0);
+    const int width = options.tileSize + (column > 0 ? options.overlap : 0) + options.overlap;
+    const int height = options.tileSize + (row > 0 ? options.overlap : 0) + options.overlap;
+    return QRect(left, top, width, height);
+}
+
+bool writeTextFile(const QString &path, const QByteArray &contents)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write(contents);
+    return file.commit();
+}
+
+// Self-contained viewer: plain canvas, tiles loaded with <img> so it also
+// works when opened straight from disk. @INFO@, @TITLE@ and @DIFFERENCE@ are
+// filled in by writeViewer.
+const char *VIEWER_TEMPLATE = R"HTML(<!DOCTYPE html>
+<html>
+<head>
+<meta charset="utf-8">
+<title>@TITLE@</title>
+<style>
+html, body { margin: 0; height: 100%; overflow: hidden; background: #222; color: #eee; font: 13px sans-serif; }
+canvas { display: block; width: 100%; height: 100%; cursor: crosshair; }
+#bar { position: fixed; top: 8px; left: 8px; padding: 6px 10px; border-radius: 5px; background: rgba(0, 0, 0, 0.6); }
+</style>
+</head>
+<body>
+<canvas id="view"></canvas>
+<div id="bar">@TITLE@ &mdash; move to wipe, drag to pan, wheel to zoom@DIFFERENCE@</div>
+<script>
+const INFO = @INFO@;
+const MAX_TILES = 600;
+const canvas = document.getElementById('view');
+const context = canvas.getContext('2d');
+const tiles = new Map();
+let ratio = 1, scale = 1, originX = 0, originY = 0, wipeX = -1;
+let showDifference = false, drag = null, drawPending = false;
+
+function requestDraw() {
+  if (!drawPending) {
+    drawPending = true;
+    requestAnimationFrame(draw);
+  }
+}
+
+// Most recently used tiles stay, the oldest are dropped past MAX_TILES
+function tile(layer, level, column, row) {
+  const key = layer + '/' + level + '/' + column + '_' + row;
+  let image = tiles.get(key);
+  if (image) {
+    tiles.delete(key);
+    tiles.set(key, image);
+    return image.complete && image.naturalWidth ? image : null;
+  }
+  image = new Image();
+  image.onload = requestDraw;
+  image.src = layer + '_files/' + level + '/' + column + '_' + row + '.' + INFO.format;
+  tiles.set(key, image);
+  if (tiles.size > MAX_TILES) tiles.delete(tiles.keys().next().value);
+  return null;
+}
+
+function drawLevel(layer, level) {
+  const factor = Math.pow(2, level - INFO.maxLevel);
+  const levelWidth = Math.ceil(INFO.width * factor);
+  const levelHeight = Math.ceil(INFO.height * factor);
+  const step = scale / factor; // screen pixels per level pixel
+  const size = INFO.tileSize;
+  const firstColumn = Math.max(0, Math.floor(-originX / step / size));
+  const lastColumn = Math.min(Math.ceil(levelWidth / size) - 1, Math.floor((canvas.width - originX) / step / size));
+  const firstRow = Math.max(0, Math.floor(-originY / step / size));
+  const lastRow = Math.min(Math.ceil(levelHeight / size) - 1, Math.floor((canvas.height - originY) / step / size));
+  for (let row = firstRow; row <= lastRow; ++row) {
+    for (let column = firstColumn; column <= lastColumn; ++column) {
+      const image = tile(layer, level, column, row);
+      if (!image) continue;
+      const x = column * size - (column > 0 ? INFO.overlap : 0);
+      const y = row * size - (row > 0 ? INFO.overlap : 0);
+      context.drawImage(image, originX + x * step, originY + y * step,
+                        image.naturalWidth * step, image.naturalHeight * step);
+    }
+  }
+}
+
+// A coarse level first fills in while the sharp tiles are still loading
+function drawLayer(layer) {
+  const level = Math.max(0, Math.min(INFO.maxLevel, INFO.maxLevel + Math.ceil(Math.log2(scale))));
+  drawLevel(layer, Math.max(0, level - 3));
+  drawLevel(layer, level);
+}
+
+function draw() {
+  drawPending = false;
+  context.fillStyle = '#222';
+  context.fillRect(0, 0, canvas.width, canvas.height);
+  context.imageSmoothingQuality = 'high';
+  if (showDifference) {
+    drawLayer('difference');
+    return;
+  }
+
+  drawLayer('first');
+  const right = Math.min(wipeX, originX + INFO.width * scale);
+  if (right > originX) {
+    const height = INFO.height * scale;
+    context.save();
+    context.beginPath();
+    context.rect(originX, originY, right - originX, height);
+    context.clip();
+    drawLayer('second');
+    context.restore();
+    context.strokeStyle = 'rgba(255, 255, 255, 0.7)';
+    context.lineWidth = 2 * ratio;
+    context.beginPath();
+    context.moveTo(right, originY);
+    context.lineTo(right, originY + height);
+    context.stroke();
+  }
+}
+
+function fit() {
+  ratio = window.devicePixelRatio || 1;
+  canvas.width = Math.round(canvas.clientWidth * ratio);
+  canvas.height = Math.round(canvas.clientHeight * ratio);
+  scale = Math.min(canvas.width / INFO.width, canvas.height / INFO.height);
+  originX = (canvas.width - INFO.width * scale) / 2;
+  originY = (canvas.height - INFO.height * scale) / 2;
+  requestDraw();
+}
+
+canvas.addEventListener('wheel', event => {
+  event.preventDefault();
+  const x = event.offsetX * ratio;
+  const y = event.offsetY * ratio;
+  const fitted = Math.min(canvas.width / INFO.width, canvas.height / INFO.height);
+  const next = Math.min(Math.max(scale * (event.deltaY < 0 ? 1.2 : 1 / 1.2), fitted / 2), 16 * ratio);
+  originX = x - (x - originX) * next / scale;
+  originY = y - (y - originY) * next / scale;
+  scale = next;
+  requestDraw();
+}, { passive: false });
+
+canvas.addEventListener('mousedown', event => {
+  drag = { x: event.offsetX * ratio, y: event.offsetY * ratio };
+  canvas.style.cursor = 'grabbing';
+});
+
+window.addEventListener('mouseup', () => {
+  drag = null;
+  canvas.style.cursor = 'crosshair';
+});
+
+canvas.addEventListener('mousemove', event => {
+  const x = event.offsetX * ratio;
+  const y = event.offsetY * ratio;
+  if (drag) {
+    originX += x - drag.x;
+    originY += y - drag.y;
+    drag = { x: x, y: y };
+  }
+  wipeX = x;
+  requestDraw();
+});
+
+canvas.addEventListener('mouseleave', () => {
+  wipeX = -1;
+  requestDraw();
+});
+
+const differenceBox = document.getElementById('difference');
+if (differenceBox) {
+  differenceBox.addEventListener('change', () => {
+    showDifference = differenceBox.checked;
+    requestDraw();
+  });
+}
+
+window.addEventListener('resize', fit);
+fit();
+</script>
+</body>
+</html>
+)HTML";
+
+} // namespace
+
+DeepZoomExport::Options::Options()
+    : tileSize(254)
+    , overlap(1)
+    , format("jpg")
+    , quality(90)
+    , includeDifference(false)
+{
+}
+
+bool DeepZoomExport::run(const QString &firstPath, const QString &secondPath, const QString &directory,
+                         const Options &options, QString *message)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // The export exists for images far beyond Qt's default 256 MB decode
+    // limit. Qt only has a process-wide limit, so once a window has exported
+    // it also opens such images itself.
+    QImageReader::setAllocationLimit(0);
+
+    // Layers are decoded one at a time, and each is released once its tiles
+    // are written; only the difference needs both images at once
+    QImage first = ImageLoader::load(firstPath);
+    if (first.isNull()) {
+        *message = QString("ERROR: cannot read %1").arg(firstPath);
+        return false;
+    }
+    if (!QDir().mkpath(directory)) {
+        *message = QString("ERROR: cannot create %1").arg(directory);
+        return false;
+    }
+
+    const QSize size = first.size();
+    QString error;
+    bool written = writePyramid(first, directory, "first", options, &error);
+    if (!options.includeDifference) {
+        first = QImage();
+    }
+
+    QImage second;
+    if (written) {
+        second = ImageLoader::load(secondPath);
+        if (second.isNull()) {
+            *message = QString("ERROR: cannot read %1").arg(secondPath);
+            return false;
+        }
+        if (second.size() != size) {
+            second = Resampler::scale(second, size);
+        }
+        written = writePyramid(second, directory, "second", options, &error);
+    }
+
+    if (written && options.includeDifference) {
+        // The difference replaces the first image's pixels, so no third
+        // full-size image is ever allocated
+        differenceInPlace(&first, second, options.differenceOptions);
+        second = QImage();
+        written = writePyramid(first, directory, "difference", options, &error);
+    }
+    first = QImage();
+    second = QImage();
+
+    written = written && writeViewer(directory, size, QFileInfo(firstPath).fileName(),
+                                     QFileInfo(secondPath).fileName(), options, &error);
+    if (!written) {
+        *message = QString("ERROR: %1").arg(error);
+        return false;
+    }
+
+    *message = QString("Exported %1x%2 deep zoom to %3 in %4 ms")
+        .arg(size.width()).arg(size.height())
+        .arg(QDir(directory).absoluteFilePath("index.html"))
+        .arg(timer.elapsed());
+    return true;
+}
+
+void DeepZoomExport::differenceInPlace(QImage *first, const QImage &second,
+                                      const PerceptualDiff::Options &options)
+{
+    // Band results are written over the first image's rows, which needs 32
+    // bits per pixel; other formats are widened once
+    const QImage::Format format = first->format();
+    if (format != QImage::Format_RGB32 && format != QImage::Format_ARGB32
+        && format != QImage::Format_ARGB32_Premultiplied) {
+        first->convertTo(QImage::Format_ARGB32);
+    }
+
+    // Each band is compared with DIFFERENCE_HALO rows of context on either
+    // side, the reach of the anti-aliasing test, so results match a compare
+    // of the whole image. The rows just above a band have been overwritten
+    // by then, so their original pixels are kept from the previous band.
+    const int width = first->width();
+    const int height = first->height();
+    const size_t rowBytes = static_cast<size_t>(width) * sizeof(QRgb);
+    QImage originalTail;
+    for (int top = 0; top < height; top += DIFFERENCE_BAND_ROWS) {
+        const int bottom = qMin(top + DIFFERENCE_BAND_ROWS, height);
+        const int cropTop = qMax(0, top - DIFFERENCE_HALO);
+        const int cropBottom = qMin(height, bottom + DIFFERENCE_HALO);
+
+        QImage firstBand = first->copy(0, cropTop, width, cropBottom - cropTop).convertToFormat(QImage::Format_ARGB32);
+        for (int y = cropTop; y < top; ++y) {
+            std::memcpy(firstBand.scanLine(y - cropTop), originalTail.constScanLine(y - (top - originalTail.height())),
+                        rowBytes);
+        }
+        const QImage secondBand = second.copy(0, cropTop, width, cropBottom - cropTop);
+
+        QImage bandDifference;
+        PerceptualDiff::compare(firstBand, secondBand, options, -1, &bandDifference);
+
+        const int tailRows = qMin(DIFFERENCE_HALO, bottom - top);
+        originalTail = firstBand.copy(0, bottom - tailRows - cropTop, width, tailRows);
+        for (int y = top; y < bottom; ++y) {
+            std::memcpy(first->scanLine(y), bandDifference.constScanLine(y - cropTop), rowBytes);
+        }
+    }
+}
+
+bool DeepZoomExport::writePyramid(const QImage &image, const QString &directory, const QString &name,
+                                  const Options &options, QString *error)
+{
+    const QString descriptor = QString(
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\" Format=\"%1\" Overlap=\"%2\" TileSize=\"%3\">\n"
+        "  <Size Width=\"%4\" Height=\"%5\"/>\n"
+        "</Image>\n")
+        .arg(options.format).arg(options.overlap).arg(options.tileSize)
+        .arg(image.width()).arg(image.height());
+    const QString descriptorPath = QDir(directory).filePath(name + ".dzi");
+    if (!writeTextFile(descriptorPath, descriptor.toUtf8())) {
+        *error = QString("cannot write %1").arg(descriptorPath);
+        return false;
+    }
+
+    // Tiles of one level are written while the next level is resampled; the
+    // writer holds its own reference, so reassigning level does not free it
+    const int maxLevel = maxLevelFor(image.size());
+    QImage level = image;
+    QFuture<bool> writing;
+    for (int index = maxLevel; index >= 0; --index) {
+        const QString levelDirectory = QDir(directory).filePath(QString("%1_files/%2").arg(name).arg(index));
+        if (writing.isValid() && !writing.result()) return false;
+        if (!QDir().mkpath(levelDirectory)) {
+            *error = QString("cannot create %1").arg(levelDirectory);
+            return false;
+        }
+
+        writing = QtConcurrent::run([level, levelDirectory, &options, error]() {
+            return writeLevel(level, levelDirectory, options, error);
+        });
+        if (index > 0) {
+            level = Resampler::scale(level, levelSize(image.size(), maxLevel, index - 1));
+        }
+    }
+    return writing.result();
+}
+
+bool DeepZoomExport::writeLevel(const QImage &level, const QString &levelDirectory,
+                                const Options &options, QString *error)
+{
+    const int columns = (level.width() + options.tileSize - 1) / options.tileSize;
+    const int rows = (level.height() + options.tileSize - 1) / options.tileSize;
+    const int quality = (options.format == "jpg") ? options.quality : -1;
+
+    QVector<int> tiles(columns * rows);
+    for (int i = 0; i < tiles.size(); ++i) {
+        tiles[i] = i;
+    }
+
+    // Once a tile fails the rest are skipped
+    std::atomic<int> failedTile(-1);
+    QtConcurrent::blockingMap(tiles, [&](int index) {
+        if (failedTile.load(std::memory_order_relaxed) >= 0) return;
+
+        const int column = index % columns;
+        const int row = index / columns;
+        const QRect rect = tileRect(column, row, options).intersected(level.rect());
+        const QString path = QString("%1/%2_%3.%4").arg(levelDirectory).arg(column).arg(row).arg(options.format);
+        if (!level.copy(rect).save(path, nullptr, quality)) {
+            failedTile.store(index);
+        }
+    });
+
+    const int failed = failedTile.load();
+    if (failed >= 0) {
+        *error = QString("cannot write %1/%2_%3.%4")
+            .arg(levelDirectory).arg(failed % columns).arg(failed / columns).arg(options.format);
+        return false;
+    }
+    return true;
+}
+
+bool DeepZoomExport::writeViewer(const QString &directory, const QSize &size, const QString &firstName,
+                                 const QString &secondName, const Options &options, QString *error)
+{
+    const QString info = QString("{ \"width\": %1, \"height\": %2, \"tileSize\": %3, \"overlap\": %4, "
+                                 "\"format\": \"%5\", \"maxLevel\": %6 }")
+        .arg(size.width()).arg(size.height()).arg(options.tileSize).arg(options.overlap)
+        .arg(options.format).arg(maxLevelFor(size));
+    const QString title = QString("%1 \u2194 %2").arg(firstName, secondName).toHtmlEscaped();
+    const QString differenceControl = options.includeDifference
+        ? QString(" <label><input type=\"checkbox\" id=\"difference\"> Difference</label>")
+        : QString();
+
+    QString html = QString::fromUtf8(VIEWER_TEMPLATE);
+    html.replace("@INFO@", info);
+    html.replace("@TITLE@", title);
+    html.replace("@DIFFERENCE@", differenceControl);
+
+    const QString viewerPath = QDir(directory).filePath("index.html");
+    if (!writeTextFile(viewerPath, html.toUtf8())) {
+        *error = QString("cannot write %1").arg(viewerPath);
+        return false;
+    }
+    return true;
+}
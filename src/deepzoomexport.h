@@ -0,0 +1,56 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#ifndef DEEPZOOMEXPORT_H
+#define DEEPZOOMEXPORT_H
+
+#include <QImage>
+#include <QString>
+#include "perceptualdiff.h"
+
+// Exports a pair as Deep Zoom (DZI) tile pyramids with a self-contained
+// index.html that pans, zooms and wipes between them in a browser.
+//
+// Each layer is written as <name>.dzi plus <name>_files/<level>/<col>_<row>.
+// Levels are produced from the full image downwards, each by halving the
+// previous one; the tiles of a level are saved on the thread pool while the
+// next level is resampled, so only two levels are ever held in memory and
+// tiles go to disk as soon as they are cut. The two images are decoded one
+// after the other, and the difference layer is computed band by band into
+// the first image's memory, so at most two full-size images are held.
+class DeepZoomExport
+{
+public:
+    struct Options {
+        Options();
+
+        int tileSize;             // tile edge without overlap
+        int overlap;              // pixels shared with each neighbouring tile
+        QString format;           // "jpg" or "png"
+        int quality;              // jpg quality, 0-100
+        bool includeDifference;   // also export a perceptual difference layer
+        PerceptualDiff::Options differenceOptions;
+    };
+
+    // Writes the pyramids and index.html into directory. A second image of
+    // another size is resampled to the first image's size so layers line up.
+    static bool run(const QString &firstPath, const QString &secondPath, const QString &directory,
+                    const Options &options, QString *message);
+
+private:
+    static void differenceInPlace(QImage *first, const QImage &second, const PerceptualDiff::Options &options);
+    static bool writePyramid(const QImage &image, const QString &directory, const QString &name,
+                             const Options &options, QString *error);
+    static bool writeLevel(const QImage &level, const QString &levelDirectory,
+                           const Options &options, QString *error);
+    static bool writeViewer(const QString &directory, const QSize &size, const QString &firstName,
+                            const QString &secondName, const Options &options, QString *error);
+
+    static const int DIFFERENCE_BAND_ROWS = 512;
+    static const int DIFFERENCE_HALO = 2; // rows the anti-aliasing test reaches past a pixel
+};
+
+#endif // DEEPZOOMEXPORT_H
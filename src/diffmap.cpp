@@ -0,0 +1,206 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#include "diffmap.h"
+#include "resampler.h"
+#include <QtConcurrent/QtConcurrentMap>
+#include <QColor>
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+
+namespace {
+
+// Sum of absolute differences over a run of bytes. Kept as a plain loop over
+// unsigned bytes so the compiler turns it into packed SAD instructions.
+inline quint32 sumAbsDiff(const uchar *a, const uchar *b, int count)
+{
+    quint32 sum = 0;
+    for (int i = 0; i < count; ++i) {
+        sum += static_cast<quint32>(std::abs(static_cast<int>(a[i]) - static_cast<int>(b[i])));
+    }
+    return sum;
+}
+
+} // namespace
+
+DiffMap::DiffMap()
+    : blockEdge(DEFAULT_BLOCK_SIZE)
+    , changeThreshold(DEFAULT_THRESHOLD)
+{
+}
+
+DiffMap DiffMap::compute(const QImage &firstImage, const QImage &secondImage, int blockSize, int threshold)
+{
+    DiffMap map;
+    if (firstImage.isNull() || secondImage.isNull() || blockSize <= 0) {
+        return map;
+    }
+
+    // Compare in a common 32-bit layout; a differently sized second image is
+    // resampled onto the first so blocks line up with what the view shows
+    const QImage first = firstImage.convertToFormat(QImage::Format_ARGB32);
+    QImage second = secondImage.convertToFormat(QImage::Format_ARGB32);
+    if (second.size() != first.size()) {
+        second = Resampler::scale(second, first.size()).convertToFormat(QImage::Format_ARGB32);
+    }
+
+    map.sourceSize = first.size();
+    map.blockEdge = blockSize;
+    map.changeThreshold = threshold;
+    map.gridSize = QSize((first.width() + blockSize - 1) / blockSize,
+                         (first.height() + blockSize - 1) / blockSize);
+    map.scores.resize(map.gridSize.width() * map.gridSize.height());
+
+    // One task per block row; each writes only its own slice of scores
+    QVector<int> blockRows(map.gridSize.height());
+    std::iota(blockRows.begin(), blockRows.end(), 0);
+
+    const int gridWidth = map.gridSize.width();
+    quint8 *scoreData = map.scores.data();
+
+    QtConcurrent::blockingMap(blockRows, [&](int blockY) {
+        QVector<quint32> sums(gridWidth, 0);
+        const int top = blockY * blockSize;
+        const int bottom = qMin(top + blockSize, first.height());
+
+        for (int y = top; y < bottom; ++y) {
+            const uchar *a = first.constScanLine(y);
+            const uchar *b = second.constScanLine(y);
+            for (int blockX = 0; blockX < gridWidth; ++blockX) {
+                const int left = blockX * blockSize;
+                const int width = qMin(blockSize, first.width() - left);
+                sums[blockX] += sumAbsDiff(a + left * 4, b + left * 4, width * 4);
+            }
+        }
+
+        const int rows = bottom - top;
+        for (int blockX = 0; blockX < gridWidth; ++blockX) {
+            const int width = qMin(blockSize, first.width() - blockX * blockSize);
+            const quint32 pixels = static_cast<quint32>(width * rows);
+            // Round up so a single changed pixel never vanishes into the mean
+            const quint32 mean = (sums[blockX] + pixels - 1) / pixels;
+            scoreData[blockY * gridWidth + blockX] = static_cast<quint8>(qMin<quint32>(mean, 255));
+        }
+    });
+
+    map.buildRegions();
+    return map;
+}
+
+DiffMap DiffMap::fromBlocks(const QSize &imageSize, int blockSize, int threshold,
+                           const QVector<quint8> &scores, const QVector<Region> &regions)
+{
+    DiffMap map;
+    if (imageSize.isEmpty() || blockSize <= 0) return map;
+
+    const QSize grid((imageSize.width() + blockSize - 1) / blockSize,
+                     (imageSize.height() + blockSize - 1) / blockSize);
+    if (scores.size() != grid.width() * grid.height()) return map;
+
+    map.sourceSize = imageSize;
+    map.gridSize = grid;
+    map.blockEdge = blockSize;
+    map.changeThreshold = threshold;
+    map.scores = scores;
+    map.changedRegions = regions;
+    return map;
+}
+
+quint8 DiffMap::score(int blockX, int blockY) const
+{
+    if (blockX < 0 || blockY < 0 || blockX >= gridSize.width() || blockY >= gridSize.height()) {
+        return 0;
+    }
+    return scores.at(blockY * gridSize.width() + blockX);
+}
+
+bool DiffMap::isChanged(int blockX, int blockY) const
+{
+    return score(blockX, blockY) >= changeThreshold;
+}
+
+QRect DiffMap::regionImageRect(int index) const
+{
+    if (index < 0 || index >= changedRegions.size()) return QRect();
+
+    const QRect &blocks = changedRegions.at(index).blocks;
+    QRect pixels(blocks.x() * blockEdge, blocks.y() * blockEdge,
+                 blocks.width() * blockEdge, blocks.height() * blockEdge);
+    return pixels.intersected(QRect(QPoint(0, 0), sourceSize));
+}
+
+QImage DiffMap::overlayImage() const
+{
+    if (isNull()) return QImage();
+
+    QImage overlay(gridSize, QImage::Format_ARGB32_Premultiplied);
+    overlay.fill(Qt::transparent);
+
+    for (int blockY = 0; blockY < gridSize.height(); ++blockY) {
+        QRgb *line = reinterpret_cast<QRgb *>(overlay.scanLine(blockY));
+        for (int blockX = 0; blockX < gridSize.width(); ++blockX) {
+            const int value = score(blockX, blockY);
+            if (value >= changeThreshold) {
+                // Faint for barely-changed blocks, strong for large differences
+                const int alpha = qBound(60, 60 + value * 2, 200);
+                line[blockX] = qPremultiply(qRgba(255, 40, 40, alpha));
+            }
+        }
+    }
+    return overlay;
+}
+
+void DiffMap::buildRegions()
+{
+    changedRegions.clear();
+
+    const int gridWidth = gridSize.width();
+    const int gridHeight = gridSize.height();
+    QVector<bool> visited(gridWidth * gridHeight, false);
+    QVector<QPoint> stack;
+
+    for (int startY = 0; startY < gridHeight; ++startY) {
+        for (int startX = 0; startX < gridWidth; ++startX) {
+            if (visited.at(startY * gridWidth + startX) || !isChanged(startX, startY)) continue;
+
+            // Flood fill the 8-connected cluster of changed blocks
+            Region region;
+            region.blocks = QRect(startX, startY, 1, 1);
+            region.blockCount = 0;
+            region.peakScore = 0;
+
+            visited[startY * gridWidth + startX] = true;
+            stack.append(QPoint(startX, startY));
+
+            while (!stack.isEmpty()) {
+                const QPoint block = stack.takeLast();
+                region.blocks = region.blocks.united(QRect(block, QSize(1, 1)));
+                region.blockCount++;
+                region.peakScore = qMax(region.peakScore, static_cast<int>(score(block.x(), block.y())));
+
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        const int x = block.x() + dx;
+                        const int y = block.y() + dy;
+                        if (x < 0 || y < 0 || x >= gridWidth || y >= gridHeight) continue;
+                        if (visited.at(y * gridWidth + x) || !isChanged(x, y)) continue;
+                        visited[y * gridWidth + x] = true;
+                        stack.append(QPoint(x, y));
+                    }
+                }
+            }
+
+            changedRegions.append(region);
+        }
+    }
+
+    // Largest clusters first, stronger differences breaking ties
+    std::stable_sort(changedRegions.begin(), changedRegions.end(), [](const Region &a, const Region &b) {
+        if (a.blockCount != b.blockCount) return a.blockCount > b.blockCount;
+        return a.peakScore > b.peakScore;
+    });
+}
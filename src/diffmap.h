@@ -0,0 +1,68 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#ifndef DIFFMAP_H
+#define DIFFMAP_H
+
+#include <QImage>
+#include <QRect>
+#include <QSize>
+#include <QVector>
+
+// Block-wise change map for an image pair. Each block stores the mean
+// per-pixel sum of absolute differences (clamped to 0-255); changed blocks
+// are grouped into 8-connected regions sorted largest first.
+class DiffMap
+{
+public:
+    struct Region {
+        QRect blocks;     // bounding rect in block coordinates
+        int blockCount;
+        int peakScore;
+    };
+
+    DiffMap();
+
+    static DiffMap compute(const QImage &firstImage, const QImage &secondImage,
+                           int blockSize = DEFAULT_BLOCK_SIZE, int threshold = DEFAULT_THRESHOLD);
+
+    // Rebuilds a map saved elsewhere (see DiffSidecar) without the images.
+    // Returns a null map when scores does not match the block grid.
+    static DiffMap fromBlocks(const QSize &imageSize, int blockSize, int threshold,
+                              const QVector<quint8> &scores, const QVector<Region> &regions);
+
+    bool isNull() const { return gridSize.isEmpty(); }
+    QSize imageSize() const { return sourceSize; }
+    QSize blockGridSize() const { return gridSize; }
+    int blockSize() const { return blockEdge; }
+    int threshold() const { return changeThreshold; }
+
+    quint8 score(int blockX, int blockY) const;
+    bool isChanged(int blockX, int blockY) const;
+    const QVector<Region> &regions() const { return changedRegions; }
+    const QVector<quint8> &blockScores() const { return scores; }
+
+    // Region bounds in image pixels, clipped to the image
+    QRect regionImageRect(int index) const;
+
+    // One pixel per block, changed blocks tinted with alpha by score
+    QImage overlayImage() const;
+
+    static const int DEFAULT_BLOCK_SIZE = 16;
+    static const int DEFAULT_THRESHOLD = 2;
+
+private:
+    void buildRegions();
+
+    QSize sourceSize;
+    QSize gridSize;
+    int blockEdge;
+    int changeThreshold;
+    QVector<quint8> scores; // row-major, gridSize.width() per row
+    QVector<Region> changedRegions;
+};
+
+#endif // DIFFMAP_H
@@ -0,0 +1,198 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#include "diffsidecar.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+namespace {
+
+const quint32 SIDECAR_MAGIC = 0x50434431; // "PCD1"
+const quint32 SIDECAR_VERSION = 3; // 1 hashed file ends only, 2 had no size and mtime
+
+} // namespace
+
+DiffSidecar::Metrics::Metrics()
+    : perceptualThreshold(-1.0)
+    , includeAntiAliasing(false)
+    , differentPixels(-1)
+    , antiAliasedPixels(0)
+{
+}
+
+QString DiffSidecar::pathFor(const QString &secondPath)
+{
+    return secondPath + ".pcdiff";
+}
+
+DiffSidecar::FileIdentity::FileIdentity()
+    : size(-1)
+    , modified(-1)
+{
+}
+
+DiffSidecar::FileIdentity DiffSidecar::fileIdentity(const QString &path)
+{
+    FileIdentity identity;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return identity;
+
+    // Every byte counts: a re-render can change pixels without touching the
+    // size, headers or trailer
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (!hash.addData(&file)) return identity;
+
+    const QFileInfo info(path);
+    identity.size = info.size();
+    identity.modified = info.lastModified().toMSecsSinceEpoch();
+    identity.hash = hash.result();
+    return identity;
+}
+
+bool DiffSidecar::matchesFile(const FileIdentity &identity, const QString &path)
+{
+    // The file as it was written is trusted without reading it; a different
+    // size or mtime (a checkout, a copy, a re-render) falls back to the hash
+    const QFileInfo info(path);
+    if (!info.isFile()) return false;
+    if (info.size() == identity.size && info.lastModified().toMSecsSinceEpoch() == identity.modified) {
+        return true;
+    }
+    return info.size() == identity.size && fileIdentity(path).hash == identity.hash;
+}
+
+bool DiffSidecar::write(const QString &firstPath, const QString &secondPath,
+                        const DiffMap &map, const Metrics &metrics)
+{
+    if (map.isNull()) return false;
+
+    const FileIdentity firstIdentity = fileIdentity(firstPath);
+    const FileIdentity secondIdentity = fileIdentity(secondPath);
+    if (firstIdentity.hash.isEmpty() || secondIdentity.hash.isEmpty()) return false;
+
+    // Written to a temporary file and renamed, like the other caches
+    QSaveFile file(pathFor(secondPath));
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream stream(&file);
+    stream << SIDECAR_MAGIC << SIDECAR_VERSION;
+    stream << firstIdentity.size << firstIdentity.modified << firstIdentity.hash;
+    stream << secondIdentity.size << secondIdentity.modified << secondIdentity.hash;
+    stream << map.imageSize() << static_cast<qint32>(map.blockSize()) << static_cast<qint32>(map.threshold());
+
+    const QSize grid = map.blockGridSize();
+    const QVector<quint8> &scores = map.blockScores();
+    QByteArray tile;
+    for (int tileY = 0; tileY < grid.height(); tileY += TILE_BLOCKS) {
+        for (int tileX = 0; tileX < grid.width(); tileX += TILE_BLOCKS) {
+            const int width = qMin(TILE_BLOCKS, grid.width() - tileX);
+            const int height = qMin(TILE_BLOCKS, grid.height() - tileY);
+            tile.resize(width * height);
+
+            bool changed = false;
+            for (int y = 0; y < height; ++y) {
+                const quint8 *row = scores.constData() + (tileY + y) * grid.width() + tileX;
+                for (int x = 0; x < width; ++x) {
+                    tile[y * width + x] = static_cast<char>(row[x]);
+                    changed |= row[x] != 0;
+                }
+            }
+            // Unchanged tiles are stored empty
+            stream << (changed ? qCompress(tile) : QByteArray());
+        }
+    }
+
+    stream << static_cast<quint32>(map.regions().size());
+    for (const DiffMap::Region &region : map.regions()) {
+        stream << region.blocks << static_cast<qint32>(region.blockCount) << static_cast<qint32>(region.peakScore);
+    }
+
+    stream << metrics.perceptualThreshold << metrics.includeAntiAliasing
+           << metrics.differentPixels << metrics.antiAliasedPixels;
+
+    if (stream.status() != QDataStream::Ok) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+bool DiffSidecar::read(const QString &firstPath, const QString &secondPath,
+                       DiffMap *map, Metrics *metrics)
+{
+    QFile file(pathFor(secondPath));
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream stream(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    FileIdentity firstIdentity;
+    FileIdentity secondIdentity;
+    stream >> magic >> version;
+    if (magic != SIDECAR_MAGIC || version != SIDECAR_VERSION) return false;
+
+    stream >> firstIdentity.size >> firstIdentity.modified >> firstIdentity.hash;
+    stream >> secondIdentity.size >> secondIdentity.modified >> secondIdentity.hash;
+    if (stream.status() != QDataStream::Ok
+        || !matchesFile(firstIdentity, firstPath) || !matchesFile(secondIdentity, secondPath)) {
+        return false;
+    }
+
+    QSize imageSize;
+    qint32 blockSize = 0;
+    qint32 threshold = 0;
+    stream >> imageSize >> blockSize >> threshold;
+    if (stream.status() != QDataStream::Ok || imageSize.isEmpty() || blockSize <= 0) return false;
+
+    const QSize grid((imageSize.width() + blockSize - 1) / blockSize,
+                     (imageSize.height() + blockSize - 1) / blockSize);
+    QVector<quint8> scores(grid.width() * grid.height(), 0);
+    QByteArray stored;
+    for (int tileY = 0; tileY < grid.height(); tileY += TILE_BLOCKS) {
+        for (int tileX = 0; tileX < grid.width(); tileX += TILE_BLOCKS) {
+            stream >> stored;
+            if (stored.isEmpty()) continue;
+
+            const int width = qMin(TILE_BLOCKS, grid.width() - tileX);
+            const int height = qMin(TILE_BLOCKS, grid.height() - tileY);
+            const QByteArray tile = qUncompress(stored);
+            if (tile.size() != width * height) return false;
+
+            for (int y = 0; y < height; ++y) {
+                quint8 *row = scores.data() + (tileY + y) * grid.width() + tileX;
+                for (int x = 0; x < width; ++x) {
+                    row[x] = static_cast<quint8>(tile.at(y * width + x));
+                }
+            }
+        }
+    }
+
+    quint32 regionCount = 0;
+    stream >> regionCount;
+    if (stream.status() != QDataStream::Ok || regionCount > static_cast<quint32>(scores.size())) return false;
+
+    QVector<DiffMap::Region> regions(static_cast<int>(regionCount));
+    for (DiffMap::Region &region : regions) {
+        qint32 blockCount = 0;
+        qint32 peakScore = 0;
+        stream >> region.blocks >> blockCount >> peakScore;
+        region.blockCount = blockCount;
+        region.peakScore = peakScore;
+    }
+
+    Metrics loaded;
+    stream >> loaded.perceptualThreshold >> loaded.includeAntiAliasing
+           >> loaded.differentPixels >> loaded.antiAliasedPixels;
+    if (stream.status() != QDataStream::Ok) return false;
+
+    *map = DiffMap::fromBlocks(imageSize, blockSize, threshold, scores, regions);
+    *metrics = loaded;
+    return !map->isNull();
+}
@@ -0,0 +1,64 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#ifndef DIFFSIDECAR_H
+#define DIFFSIDECAR_H
+
+#include <QByteArray>
+#include <QString>
+#include "diffmap.h"
+
+// Saved analysis for an image pair, written beside the second image so a
+// reviewed pair reopens with its change map and counts without decoding
+// anything. The block scores are split into tiles that are compressed on
+// their own, and unchanged tiles are not stored at all, so a mostly
+// identical pair costs a few hundred bytes.
+//
+// Entries are tied to the content of both files rather than their paths or
+// mtimes, which do not survive checkouts and artifact copies: each file is
+// identified by a hash of its full contents. The size and mtime are stored
+// too, so a file untouched since the sidecar was written is matched without
+// reading it; only when they differ is the file hashed again.
+class DiffSidecar
+{
+public:
+    // Perceptual counts from the run that wrote the sidecar
+    struct Metrics {
+        Metrics();
+
+        bool isValid() const { return differentPixels >= 0; }
+
+        double perceptualThreshold;
+        bool includeAntiAliasing;
+        qint64 differentPixels;   // -1 when the run did not count perceptually
+        qint64 antiAliasedPixels;
+    };
+
+    static QString pathFor(const QString &secondPath);
+
+    static bool write(const QString &firstPath, const QString &secondPath,
+                      const DiffMap &map, const Metrics &metrics);
+
+    // False when there is no sidecar or either file changed since it was written
+    static bool read(const QString &firstPath, const QString &secondPath,
+                     DiffMap *map, Metrics *metrics);
+
+    static const int TILE_BLOCKS = 64; // tile edge in blocks
+
+private:
+    struct FileIdentity {
+        FileIdentity();
+
+        qint64 size;
+        qint64 modified; // ms since the epoch
+        QByteArray hash; // SHA-1 of the whole file
+    };
+
+    static FileIdentity fileIdentity(const QString &path);
+    static bool matchesFile(const FileIdentity &identity, const QString &path);
+};
+
+#endif // DIFFSIDECAR_H
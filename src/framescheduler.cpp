@@ -0,0 +1,100 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#include "framescheduler.h"
+#include <QScreen>
+#include <cmath>
+
+FrameScheduler::Stats::Stats()
+    : frames(0)
+    , coalescedInputs(0)
+    , lastLatencyMs(0.0)
+    , averageLatencyMs(0.0)
+    , maxLatencyMs(0.0)
+    , frameIntervalMs(0.0)
+{
+}
+
+FrameScheduler::FrameScheduler(QWidget *target)
+    : QObject(target)
+    , target(target)
+    , frameTimer(nullptr)
+    , pendingSinceNs(-1)
+    , lastFrameNs(-1)
+    , frameScheduled(false)
+{
+    clock.start();
+
+    frameTimer = new QTimer(this);
+    frameTimer->setSingleShot(true);
+    frameTimer->setTimerType(Qt::PreciseTimer);
+    connect(frameTimer, &QTimer::timeout, this, &FrameScheduler::onFrameTimer);
+}
+
+double FrameScheduler::framePeriodMs() const
+{
+    QScreen *screen = target->screen();
+    double rate = screen ? screen->refreshRate() : DEFAULT_REFRESH_RATE;
+    if (rate <= 1.0) rate = DEFAULT_REFRESH_RATE;
+    return 1000.0 / rate;
+}
+
+void FrameScheduler::requestFrame()
+{
+    const qint64 now = clock.nsecsElapsed();
+    if (pendingSinceNs < 0) {
+        pendingSinceNs = now;
+    } else {
+        ++frameStats.coalescedInputs;
+    }
+    if (frameScheduled) return;
+
+    // Back-to-back frames are spaced one refresh apart; the first frame after
+    // an idle period goes out immediately
+    frameScheduled = true;
+    const double period = framePeriodMs();
+    double delay = 0.0;
+    if (lastFrameNs >= 0) {
+        delay = qMax(0.0, period - (now - lastFrameNs) / 1e6);
+    }
+    frameTimer->start(static_cast<int>(std::floor(delay)));
+}
+
+void FrameScheduler::onFrameTimer()
+{
+    frameScheduled = false;
+    emit frameDue();
+    target->update();
+}
+
+void FrameScheduler::framePainted()
+{
+    const qint64 now = clock.nsecsElapsed();
+    lastFrameNs = now;
+    frameStats.frameIntervalMs = framePeriodMs();
+    if (pendingSinceNs < 0) return;
+
+    // Only paints that show input count towards latency
+    const double latency = (now - pendingSinceNs) / 1e6;
+    pendingSinceNs = -1;
+    frameStats.lastLatencyMs = latency;
+    frameStats.averageLatencyMs = (frameStats.frames == 0)
+        ? latency
+        : frameStats.averageLatencyMs + AVERAGE_WEIGHT * (latency - frameStats.averageLatencyMs);
+    frameStats.maxLatencyMs = qMax(frameStats.maxLatencyMs, latency);
+    ++frameStats.frames;
+}
+
+FrameScheduler::Stats FrameScheduler::stats() const
+{
+    return frameStats;
+}
+
+void FrameScheduler::resetStats()
+{
+    frameStats = Stats();
+    frameStats.frameIntervalMs = framePeriodMs();
+}
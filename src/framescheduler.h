@@ -0,0 +1,71 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <QObject>
+#include <QWidget>
+#include <QTimer>
+#include <QElapsedTimer>
+
+// Paces repaints of one widget to the display's refresh rate.
+//
+// Input handlers record their latest state and call requestFrame() instead of
+// update(). At most one frame is ever pending: when it is due, frameDue() asks
+// the widget to apply the coalesced input, and the widget repaints once.
+// Input that arrives while a frame is pending only updates that frame, so a
+// slow paint never builds a backlog. After an idle period the frame is
+// scheduled immediately rather than waiting for the next refresh.
+//
+// Latency is measured from the oldest input folded into a frame to the end
+// of the paint that shows it.
+class FrameScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Stats {
+        Stats();
+
+        qint64 frames;            // paints measured since the last reset
+        qint64 coalescedInputs;   // requests folded into an already pending frame
+        double lastLatencyMs;
+        double averageLatencyMs;  // exponential moving average
+        double maxLatencyMs;
+        double frameIntervalMs;   // display refresh period frames are paced to
+    };
+
+    explicit FrameScheduler(QWidget *target);
+
+    void requestFrame();
+    void framePainted(); // call at the end of the target's paintEvent
+
+    Stats stats() const;
+    void resetStats();
+
+signals:
+    void frameDue();
+
+private slots:
+    void onFrameTimer();
+
+private:
+    double framePeriodMs() const;
+
+    QWidget *target;
+    QTimer *frameTimer;
+    QElapsedTimer clock;
+    qint64 pendingSinceNs;   // oldest input not yet painted, -1 when none
+    qint64 lastFrameNs;      // end of the last paint, -1 before the first
+    bool frameScheduled;
+    Stats frameStats;
+
+    static constexpr double DEFAULT_REFRESH_RATE = 60.0;
+    static constexpr double AVERAGE_WEIGHT = 0.1;
+};
+
+#endif // FRAMESCHEDULER_H
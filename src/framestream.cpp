@@ -0,0 +1,305 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#include "framestream.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char FRAME_MAGIC[4] = {'P', 'C', 'F', 'R'};
+const char SHM_MAGIC[4] = {'P', 'C', 'S', 'M'};
+const qint64 SHM_PREFIX_SIZE = 8; // magic + sequence
+const int DISCARD_CHUNK = 64 * 1024;
+
+} // namespace
+
+FrameStream::FrameStream(QObject *parent)
+    : QObject(parent)
+    , pipeFd(-1)
+    , pipeNotifier(nullptr)
+    , headerFilled(0)
+    , readingPayload(false)
+    , payloadStride(0)
+    , payloadSize(0)
+    , payloadFilled(0)
+    , shmFd(-1)
+    , shmData(nullptr)
+    , shmSize(0)
+    , lastSequence(0)
+    , shmTimer(nullptr)
+{
+    static_assert(sizeof(FrameHeader) == 20, "frame header must match the wire format");
+}
+
+FrameStream::~FrameStream()
+{
+    stop();
+}
+
+bool FrameStream::open(const QString &source, QString *error)
+{
+    if (source == "-") {
+        return openPipe(STDIN_FILENO, error);
+    }
+    if (source.startsWith("shm:")) {
+        return openSharedMemory(source.mid(4), error);
+    }
+    *error = QString("unknown frame source: %1 (use - or shm:<name>)").arg(source);
+    return false;
+}
+
+bool FrameStream::openPipe(int fd, QString *error)
+{
+    // Non-blocking reads driven by the event loop: a large frame arrives in
+    // pipe-buffer sized pieces without ever stalling the GUI thread
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        *error = QString("cannot configure frame pipe: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+        return false;
+    }
+
+    pipeFd = fd;
+    pipeNotifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(pipeNotifier, &QSocketNotifier::activated, this, &FrameStream::onPipeReadable);
+    return true;
+}
+
+bool FrameStream::openSharedMemory(const QString &name, QString *error)
+{
+    QByteArray shmName = name.toLocal8Bit();
+    if (!shmName.startsWith('/')) {
+        shmName.prepend('/');
+    }
+
+    shmFd = shm_open(shmName.constData(), O_RDONLY, 0);
+    if (shmFd < 0) {
+        *error = QString("cannot open shared memory %1: %2").arg(name, QString::fromLocal8Bit(strerror(errno)));
+        return false;
+    }
+
+    // The writer may create the segment before sizing it; mapping is retried on every poll
+    mapSharedMemory();
+
+    shmTimer = new QTimer(this);
+    connect(shmTimer, &QTimer::timeout, this, &FrameStream::onSharedMemoryPoll);
+    shmTimer->start(SHM_POLL_INTERVAL_MS);
+    return true;
+}
+
+bool FrameStream::mapSharedMemory()
+{
+    struct stat info;
+    if (fstat(shmFd, &info) != 0 || info.st_size < static_cast<off_t>(SHM_PREFIX_SIZE + sizeof(FrameHeader))) {
+        return false;
+    }
+
+    void *data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, shmFd, 0);
+    if (data == MAP_FAILED) return false;
+
+    shmData = static_cast<uchar *>(data);
+    shmSize = info.st_size;
+    return true;
+}
+
+void FrameStream::unmapSharedMemory()
+{
+    if (shmData) {
+        munmap(shmData, static_cast<size_t>(shmSize));
+        shmData = nullptr;
+        shmSize = 0;
+    }
+}
+
+bool FrameStream::validateHeader(const FrameHeader &header, QImage::Format *format,
+                                 qint64 *stride, qint64 *payloadSize)
+{
+    if (std::memcmp(header.magic, FRAME_MAGIC, 4) != 0 || header.side > 1) return false;
+    if (header.width == 0 || header.height == 0 || header.width > MAX_DIMENSION || header.height > MAX_DIMENSION) {
+        return false;
+    }
+
+    switch (header.format) {
+        case 0: *format = QImage::Format_Grayscale8; break;
+        case 1: *format = QImage::Format_RGB888; break;
+        case 2: *format = QImage::Format_RGBA8888; break;
+        case 3: *format = QImage::Format_ARGB32; break;
+        case 4: *format = QImage::Format_Grayscale16; break;
+        case 5: *format = QImage::Format_RGBA64; break;
+        default: return false;
+    }
+
+    const qint64 rowBytes = static_cast<qint64>(header.width) * QImage::toPixelFormat(*format).bitsPerPixel() / 8;
+    *stride = header.stride == 0 ? rowBytes : header.stride;
+    if (*stride < rowBytes || *stride > rowBytes + MAX_ROW_PADDING) return false;
+
+    *payloadSize = *stride * header.height;
+    return *payloadSize <= MAX_FRAME_BYTES;
+}
+
+void FrameStream::onPipeReadable()
+{
+    QImage latest[2];
+
+    for (;;) {
+        ssize_t count;
+        if (!readingPayload) {
+            char *headerBytes = reinterpret_cast<char *>(&pendingHeader);
+            count = ::read(pipeFd, headerBytes + headerFilled, sizeof(FrameHeader) - headerFilled);
+            if (count > 0) {
+                headerFilled += static_cast<int>(count);
+                if (headerFilled == static_cast<int>(sizeof(FrameHeader))) {
+                    QImage::Format format;
+                    if (!validateHeader(pendingHeader, &format, &payloadStride, &payloadSize)) {
+                        qWarning("Frame stream: invalid frame header, closing stream");
+                        stop();
+                        emit finished();
+                        return;
+                    }
+                    // A frame that cannot be allocated is still read, then dropped,
+                    // so the stream stays in step with the writer
+                    payload = QImage(static_cast<int>(pendingHeader.width),
+                                     static_cast<int>(pendingHeader.height), format);
+                    if (payload.isNull()) {
+                        qWarning("Frame stream: cannot allocate a %ux%u frame, dropping it",
+                                 pendingHeader.width, pendingHeader.height);
+                    }
+                    readingPayload = true;
+                    payloadFilled = 0;
+                }
+            }
+        } else {
+            // Rows land in the image's own scan lines; row padding on the wire
+            // and dropped frames are read into a scratch buffer
+            char discard[DISCARD_CHUNK];
+            char *target = discard;
+            qint64 wanted = qMin<qint64>(DISCARD_CHUNK, payloadSize - payloadFilled);
+            if (!payload.isNull()) {
+                if (payloadStride == payload.bytesPerLine()) {
+                    target = reinterpret_cast<char *>(payload.bits()) + payloadFilled;
+                    wanted = payloadSize - payloadFilled;
+                } else {
+                    const qint64 rowBytes = static_cast<qint64>(payload.width()) * payload.depth() / 8;
+                    const int row = static_cast<int>(payloadFilled / payloadStride);
+                    const qint64 column = payloadFilled % payloadStride;
+                    if (column < rowBytes) {
+                        target = reinterpret_cast<char *>(payload.scanLine(row)) + column;
+                        wanted = rowBytes - column;
+                    } else {
+                        wanted = payloadStride - column;
+                    }
+                }
+            }
+            count = ::read(pipeFd, target, static_cast<size_t>(wanted));
+            if (count > 0) {
+                payloadFilled += count;
+                if (payloadFilled == payloadSize) {
+                    if (!payload.isNull()) {
+                        latest[pendingHeader.side] = payload;
+                    }
+                    payload = QImage();
+                    readingPayload = false;
+                    headerFilled = 0;
+                }
+            }
+        }
+
+        if (count == 0) {
+            // Writer closed the pipe
+            for (int side = 0; side < 2; ++side) {
+                if (!latest[side].isNull()) emit frameReceived(side, latest[side]);
+            }
+            stop();
+            emit finished();
+            return;
+        }
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                qWarning("Frame stream: read failed: %s", strerror(errno));
+                stop();
+                emit finished();
+                return;
+            }
+            break;
+        }
+    }
+
+    // Frames that arrived together are coalesced: only the newest per side is shown
+    for (int side = 0; side < 2; ++side) {
+        if (!latest[side].isNull()) emit frameReceived(side, latest[side]);
+    }
+}
+
+void FrameStream::onSharedMemoryPoll()
+{
+    // Follow the writer when it grows or shrinks the segment
+    struct stat info;
+    if (fstat(shmFd, &info) == 0 && info.st_size != shmSize) {
+        unmapSharedMemory();
+        mapSharedMemory();
+    }
+    if (!shmData || std::memcmp(shmData, SHM_MAGIC, 4) != 0) return;
+
+    const volatile quint32 *sequence = reinterpret_cast<const volatile quint32 *>(shmData + 4);
+    const quint32 before = *sequence;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if ((before & 1) || before == lastSequence) return;
+
+    FrameHeader header;
+    std::memcpy(&header, shmData + SHM_PREFIX_SIZE, sizeof(FrameHeader));
+    QImage::Format format;
+    qint64 stride;
+    qint64 size;
+    if (!validateHeader(header, &format, &stride, &size)) return;
+    if (SHM_PREFIX_SIZE + static_cast<qint64>(sizeof(FrameHeader)) + size > shmSize) return;
+
+    // Copy rows out of the segment so the writer can move on to the next frame
+    const uchar *pixels = shmData + SHM_PREFIX_SIZE + sizeof(FrameHeader);
+    QImage image(static_cast<int>(header.width), static_cast<int>(header.height), format);
+    if (image.isNull()) {
+        qWarning("Frame stream: cannot allocate a %ux%u frame, dropping it", header.width, header.height);
+        lastSequence = before;
+        return;
+    }
+    const qint64 rowBytes = qMin<qint64>(stride, image.bytesPerLine());
+    for (int y = 0; y < image.height(); ++y) {
+        std::memcpy(image.scanLine(y), pixels + y * stride, static_cast<size_t>(rowBytes));
+    }
+
+    // Drop the copy if the writer started another frame while we read
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (*sequence != before) return;
+
+    lastSequence = before;
+    emit frameReceived(header.side, image);
+}
+
+void FrameStream::stop()
+{
+    if (pipeNotifier) {
+        pipeNotifier->setEnabled(false);
+        pipeNotifier->deleteLater();
+        pipeNotifier = nullptr;
+    }
+    payload = QImage();
+    readingPayload = false;
+    pipeFd = -1;
+
+    if (shmTimer) {
+        shmTimer->stop();
+    }
+    unmapSharedMemory();
+    if (shmFd >= 0) {
+        ::close(shmFd);
+        shmFd = -1;
+    }
+}
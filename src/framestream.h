@@ -0,0 +1,96 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#ifndef FRAMESTREAM_H
+#define FRAMESTREAM_H
+
+#include <QObject>
+#include <QImage>
+#include <QSocketNotifier>
+#include <QTimer>
+
+// Raw frame input from a pipe (stdin) or a POSIX shared-memory segment, so a
+// renderer can push pixels without encoding them to a file first.
+//
+// Every frame starts with a 20-byte little-endian header:
+//
+//   char    magic[4]   "PCFR"
+//   uint8   side       0 = first image, 1 = second image
+//   uint8   format     0 Gray8, 1 RGB888, 2 RGBA8888, 3 BGRA8888 (ARGB32),
+//                      4 Gray16, 5 RGBA16161616
+//   uint16  reserved
+//   uint32  width
+//   uint32  height
+//   uint32  stride     bytes per row, 0 for tightly packed rows
+//
+// followed by height * stride bytes of pixels. The stride may pad a row by at
+// most MAX_ROW_PADDING bytes, and a frame may hold at most MAX_FRAME_BYTES.
+// A shared-memory segment holds a "PCSM" magic and a uint32 sequence number
+// in front of one such frame; the writer makes the sequence odd while it
+// updates the frame and even again when the frame is complete.
+class FrameStream : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FrameStream(QObject *parent = nullptr);
+    ~FrameStream();
+
+    // source is "-" for stdin or "shm:<name>" for a shared-memory segment
+    bool open(const QString &source, QString *error);
+
+signals:
+    void frameReceived(int side, const QImage &image);
+    void finished();
+
+private slots:
+    void onPipeReadable();
+    void onSharedMemoryPoll();
+
+private:
+    struct FrameHeader {
+        char magic[4];
+        quint8 side;
+        quint8 format;
+        quint16 reserved;
+        quint32 width;
+        quint32 height;
+        quint32 stride;
+    };
+
+    bool openPipe(int fd, QString *error);
+    bool openSharedMemory(const QString &name, QString *error);
+    bool mapSharedMemory();
+    void unmapSharedMemory();
+    static bool validateHeader(const FrameHeader &header, QImage::Format *format,
+                               qint64 *stride, qint64 *payloadSize);
+    void stop();
+
+    // Pipe state
+    int pipeFd;
+    QSocketNotifier *pipeNotifier;
+    FrameHeader pendingHeader;
+    int headerFilled;
+    bool readingPayload;
+    QImage payload;     // rows are read straight into it; null while a frame is dropped
+    qint64 payloadStride;
+    qint64 payloadSize;
+    qint64 payloadFilled;
+
+    // Shared-memory state
+    int shmFd;
+    uchar *shmData;
+    qint64 shmSize;
+    quint32 lastSequence;
+    QTimer *shmTimer;
+
+    static const int SHM_POLL_INTERVAL_MS = 4;
+    static const quint32 MAX_DIMENSION = 65535;
+    static const quint32 MAX_ROW_PADDING = 64;
+    static const qint64 MAX_FRAME_BYTES = Q_INT64_C(1) << 30;
+};
+
+#endif // FRAMESTREAM_H
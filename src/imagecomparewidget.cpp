@@ -7,9 +7,29 @@
 #include "imagecomparewidget.h"
 #include <QPaintEvent>
 #include <QFileInfo>
+#include <QFutureWatcher>
+#include <QThreadPool>
+#include <QDebug>
+#include <QGuiApplication>
+#include <QtConcurrent/QtConcurrentRun>
+#include "imageloader.h"
+#include "pyramidcache.h"
+#include "resampler.h"
+#include <algorithm>
+#include <cmath>
 
 ImageCompareWidget::ImageCompareWidget(QWidget *parent)
     : QWidget(parent)
+    , showInfoPanel(false)
+    , statsRunning(false)
+    , renderer(nullptr)
+    , firstIsFullResolution(false)
+    , secondIsFullResolution(false)
+    , loadGeneration(0)
+    , firstDecodeGeneration(0)
+    , secondDecodeGeneration(0)
+    , firstPixelsReported(true)
+    , fullResolutionReported(true)
     , direction(LeftToRight)
     , compareMode(WipeMode)
     , revealPosition(0.0)
@@ -18,6 +38,10 @@ ImageCompareWidget::ImageCompareWidget(QWidget *parent)
     , panOffset(0, 0)
     , lastPanPoint(0, 0)
     , isPanning(false)
+    , frameScheduler(nullptr)
+    , mouseMovePending(false)
+    , pendingZoomSteps(0)
+    , showFrameStats(false)
     , dissolveTimer(nullptr)
     , opacityAnimation(nullptr)
     , currentOpacity(0.0)
@@ -25,11 +49,37 @@ ImageCompareWidget::ImageCompareWidget(QWidget *parent)
     , transitionTime(1.0)
     , isDissolving(false)
     , showingSecondImage(false)
+    , flipped(false)
+    , loupeEnabled(false)
+    , loupeCursor(-1, -1)
+    , loupeMagnification(1)
+    , loupeFirstColumns(LOUPE_SIZE, -1)
+    , loupeSecondColumns(LOUPE_SIZE, -1)
+    , loupeColumnSide(LOUPE_SIZE, 0)
+    , showChangeOverlay(false)
+    , currentRegion(-1)
+    , changeMapGeneration(0)
+    , changeMapWanted(false)
+    , changeMapRunning(false)
+    , changeMapSaved(false)
+    , differenceGeneration(0)
+    , differenceImageGeneration(-1)
+    , differenceRunning(false)
 {
     setMouseTracking(true);
     setMinimumSize(DEFAULT_WIDTH, DEFAULT_HEIGHT);
     setFocusPolicy(Qt::StrongFocus); // Enable keyboard events
     
+    // Finished frames from the render thread are picked up by the next paint
+    renderer = new ViewRenderer(this);
+    connect(renderer, &ViewRenderer::frameReady, this, [this]() {
+        update();
+    });
+    
+    // Mouse, wheel and animation updates are applied once per display frame
+    frameScheduler = new FrameScheduler(this);
+    connect(frameScheduler, &FrameScheduler::frameDue, this, &ImageCompareWidget::applyPendingInput);
+    
     // Initialize dissolve timer
     dissolveTimer = new QTimer(this);
     connect(dissolveTimer, &QTimer::timeout, this, &ImageCompareWidget::onDissolveTimer);
@@ -43,18 +93,303 @@ ImageCompareWidget::ImageCompareWidget(QWidget *parent)
 
 void ImageCompareWidget::setImages(const QString &firstImagePath, const QString &secondImagePath)
 {
-    firstImage = QPixmap(firstImagePath);
-    secondImage = QPixmap(secondImagePath);
+    ++loadGeneration;
+    ++firstDecodeGeneration;
+    ++secondDecodeGeneration;
+    firstImage = QImage();
+    secondImage = QImage();
+    firstStats = ImageStats();
+    secondStats = ImageStats();
+    firstIsFullResolution = false;
+    secondIsFullResolution = false;
+    revealPosition = 0.0; // Reset reveal position
+    changeMap = DiffMap();
+    changeOverlay = QImage();
+    currentRegion = -1;
+    cancelChangeMap();
+    changeMapSaved = false;
+    differenceImage = QImage(); // belongs to the previous pair
+    invalidateDifference();
     
-    if (!firstImage.isNull() && !secondImage.isNull()) {
-        hasImages = true;
-        // Scale images will be done in paintEvent to always fit current widget size
-        revealPosition = 0.0; // Reset reveal position
-        update(); // Trigger repaint
-    } else {
-        hasImages = false;
+    savedMetrics = DiffSidecar::Metrics();
+    startSidecarRead(firstImagePath, secondImagePath);
+    
+    loadTimer.start();
+    firstPixelsReported = false;
+    fullResolutionReported = false;
+    
+    // Show a cached pyramid level, or failing that the embedded EXIF preview,
+    // straight away; full decodes replace them without touching the view.
+    // Cached levels are used in place, straight from the mapped file.
+    bool firstCached = false;
+    bool secondCached = false;
+    firstImage = loadPreview(firstImagePath, &firstCached);
+    secondImage = loadPreview(secondImagePath, &secondCached);
+    previewSource = (firstCached && secondCached) ? "pyramid cache" : "embedded preview";
+    hasImages = !firstImage.isNull() && !secondImage.isNull();
+    update();
+    emit imagesChanged();
+    
+    startFullLoad(0, firstImagePath, !firstCached);
+    startFullLoad(1, secondImagePath, !secondCached);
+}
+
+void ImageCompareWidget::setImage(int side, const QImage &image)
+{
+    // Drop this side's file decode if it is still in flight, so it cannot
+    // replace the image; the other side's decode carries on
+    ++loadGeneration;
+    ++(side == 0 ? firstDecodeGeneration : secondDecodeGeneration);
+    cancelChangeMap();
+    changeMapSaved = false;
+    savedMetrics = DiffSidecar::Metrics();
+    (side == 0 ? firstStats : secondStats) = ImageStats();
+    setSideImage(side, image, true);
+}
+
+void ImageCompareWidget::setFrames(const QImage &first, const QImage &second, bool analyze)
+{
+    // A frame replaces its side's file decode if that is still in flight;
+    // zoom, pan, reveal and dissolve state carry over from frame to frame
+    ++loadGeneration;
+    if (!first.isNull()) {
+        ++firstDecodeGeneration;
+        firstImage = first;
+        firstStats = ImageStats();
+        firstIsFullResolution = true;
+    }
+    if (!second.isNull()) {
+        ++secondDecodeGeneration;
+        secondImage = second;
+        secondStats = ImageStats();
+        secondIsFullResolution = true;
+    }
+    hasImages = !firstImage.isNull() && !secondImage.isNull();
+    invalidateDifference();
+    updateDifferenceImage();
+    startStats();
+    
+    changeMap = DiffMap();
+    changeOverlay = QImage();
+    currentRegion = -1;
+    savedMetrics = DiffSidecar::Metrics();
+    cancelChangeMap();
+    changeMapSaved = false;
+    if (analyze && hasImages) {
+        requestChangeMap();
+    }
+    update();
+    emit imagesChanged();
+}
+
+QImage ImageCompareWidget::loadPreview(const QString &path, bool *fromCache) const
+{
+    QImage preview = PyramidCache::lookup(path, size());
+    *fromCache = !preview.isNull();
+    if (preview.isNull()) {
+        preview = ImageLoader::loadEmbeddedPreview(path);
+    }
+    return preview;
+}
+
+void ImageCompareWidget::setLaunchTimer(const QElapsedTimer &timer)
+{
+    launchTimer = timer;
+}
+
+void ImageCompareWidget::reportLoadTiming(const QString &stage)
+{
+    QString message = QString("%1 after %2 ms").arg(stage).arg(loadTimer.elapsed());
+    if (launchTimer.isValid()) {
+        message += QString(", %1 ms since launch").arg(launchTimer.elapsed());
+    }
+    qInfo().noquote() << message;
+}
+
+void ImageCompareWidget::startFullLoad(int side, const QString &path, bool cacheAfterLoad)
+{
+    int generation = (side == 0 ? firstDecodeGeneration : secondDecodeGeneration);
+    QFutureWatcher<LoadedImage> *watcher = new QFutureWatcher<LoadedImage>(this);
+    connect(watcher, &QFutureWatcher<LoadedImage>::finished, this, [this, watcher, side, path, generation, cacheAfterLoad]() {
+        const LoadedImage loaded = watcher->result();
+        const QImage &image = loaded.image;
+        watcher->deleteLater();
+        
+        // A newer pair or frame replaced this side while it decoded
+        if (generation != (side == 0 ? firstDecodeGeneration : secondDecodeGeneration)) return;
+        
+        // Keep the preview when Qt cannot decode the file itself (camera raws)
+        if (image.isNull() && !(side == 0 ? firstImage : secondImage).isNull()) return;
+        
+        (side == 0 ? firstStats : secondStats) = loaded.stats;
+        setSideImage(side, image, true);
+        
+        // Populate the pyramid cache for the next time this file is opened
+        if (cacheAfterLoad && !image.isNull()) {
+            QThreadPool::globalInstance()->start([path, image]() {
+                PyramidCache::store(path, image);
+            });
+        }
+    });
+    watcher->setFuture(QtConcurrent::run([path]() {
+        LoadedImage loaded;
+        loaded.image = ImageLoader::loadWithStats(path, &loaded.stats);
+        return loaded;
+    }));
+}
+
+void ImageCompareWidget::startSidecarRead(const QString &firstPath, const QString &secondPath)
+{
+    // A sidecar from an earlier headless run restores the change map and
+    // counts, usually before either image has decoded. Checking it may hash
+    // both files, so that happens on the pool as well.
+    int generation = loadGeneration;
+    QFutureWatcher<SavedAnalysis> *watcher = new QFutureWatcher<SavedAnalysis>(this);
+    connect(watcher, &QFutureWatcher<SavedAnalysis>::finished, this, [this, watcher, generation]() {
+        const SavedAnalysis saved = watcher->result();
+        watcher->deleteLater();
+        
+        if (generation != loadGeneration || !saved.found) return;
+        
+        // The saved map stands in for a build from the images: one already
+        // started is cancelled, one already finished is kept
+        savedMetrics = saved.metrics;
+        const bool fits = !firstIsFullResolution || saved.map.imageSize() == firstImage.size();
+        if (fits && (changeMapWanted || changeMap.isNull())) {
+            cancelChangeMap();
+            changeMap = saved.map;
+            changeOverlay = changeMap.overlayImage();
+            changeMapSaved = true;
+            if (currentRegion >= changeMap.regions().size()) {
+                currentRegion = -1;
+            }
+        }
         update();
+    });
+    watcher->setFuture(QtConcurrent::run([firstPath, secondPath]() {
+        SavedAnalysis saved;
+        saved.found = DiffSidecar::read(firstPath, secondPath, &saved.map, &saved.metrics);
+        return saved;
+    }));
+}
+
+void ImageCompareWidget::startStats()
+{
+    // Images handed in directly (setImage, streamed and sequence frames) come
+    // without the stats a file decode gathers. They are worked out here while
+    // the panel shows them, one pass at a time; a pass overtaken by newer
+    // images is dropped and started again from the current ones.
+    const bool firstMissing = firstIsFullResolution && !firstStats.isValid();
+    const bool secondMissing = secondIsFullResolution && !secondStats.isValid();
+    if (!showInfoPanel || statsRunning || !(firstMissing || secondMissing)) return;
+    
+    statsRunning = true;
+    const int generation = loadGeneration;
+    const QImage first = firstMissing ? firstImage : QImage();
+    const QImage second = secondMissing ? secondImage : QImage();
+    
+    QFutureWatcher<PairStats> *watcher = new QFutureWatcher<PairStats>(this);
+    connect(watcher, &QFutureWatcher<PairStats>::finished, this, [this, watcher, generation, firstMissing, secondMissing]() {
+        const PairStats stats = watcher->result();
+        watcher->deleteLater();
+        statsRunning = false;
+        
+        if (generation != loadGeneration) {
+            startStats();
+            return;
+        }
+        if (firstMissing) firstStats = stats.first;
+        if (secondMissing) secondStats = stats.second;
+        update();
+    });
+    watcher->setFuture(QtConcurrent::run([first, second]() {
+        PairStats stats;
+        stats.first = ImageStats::compute(first);
+        stats.second = ImageStats::compute(second);
+        return stats;
+    }));
+}
+
+void ImageCompareWidget::setSideImage(int side, const QImage &image, bool fullResolution)
+{
+    // Only the source pixels change; zoom, pan and reveal state are kept.
+    // Images stay in the format they arrive in and are converted for display
+    // per tile as tiles are drawn.
+    if (side == 0) {
+        firstImage = image;
+        firstIsFullResolution = fullResolution && !image.isNull();
+    } else {
+        secondImage = image;
+        secondIsFullResolution = fullResolution && !image.isNull();
+    }
+    hasImages = !firstImage.isNull() && !secondImage.isNull();
+    invalidateDifference();
+    updateDifferenceImage();
+    startStats();
+    
+    // Build the change map once per pair, from full-resolution data only,
+    // unless the sidecar already holds it for an image of this size
+    if (hasImages && firstIsFullResolution && secondIsFullResolution) {
+        if (!changeMapSaved || changeMap.imageSize() != firstImage.size()) {
+            requestChangeMap();
+        }
+        
+        if (!fullResolutionReported) {
+            fullResolutionReported = true;
+            reportLoadTiming("Full resolution");
+            launchTimer.invalidate(); // only the first pair is a cold start
+        }
     }
+    update();
+    emit imagesChanged();
+}
+
+void ImageCompareWidget::requestChangeMap()
+{
+    ++changeMapGeneration;
+    changeMapWanted = true;
+    startChangeMap();
+}
+
+void ImageCompareWidget::cancelChangeMap()
+{
+    ++changeMapGeneration;
+    changeMapWanted = false;
+}
+
+void ImageCompareWidget::startChangeMap()
+{
+    // One map in flight at a time; one overtaken by newer images is dropped
+    // and the map is started again from the current ones
+    if (!changeMapWanted || changeMapRunning || !hasImages) return;
+    
+    changeMapRunning = true;
+    const int generation = changeMapGeneration;
+    const QImage first = firstImage;
+    const QImage second = secondImage;
+    
+    QFutureWatcher<DiffMap> *watcher = new QFutureWatcher<DiffMap>(this);
+    connect(watcher, &QFutureWatcher<DiffMap>::finished, this, [this, watcher, generation]() {
+        const DiffMap map = watcher->result();
+        watcher->deleteLater();
+        changeMapRunning = false;
+        
+        if (generation != changeMapGeneration) {
+            startChangeMap();
+            return;
+        }
+        changeMapWanted = false;
+        changeMap = map;
+        changeOverlay = changeMap.overlayImage();
+        changeMapSaved = false;
+        if (currentRegion >= changeMap.regions().size()) {
+            currentRegion = -1;
+        }
+        update();
+    });
+    watcher->setFuture(QtConcurrent::run([first, second]() {
+        return DiffMap::compute(first, second);
+    }));
 }
 
 void ImageCompareWidget::setDirection(CompareDirection newDirection)
@@ -78,93 +413,58 @@ void ImageCompareWidget::paintEvent(QPaintEvent *event)
         // Draw placeholder text with system theme colors
         painter.fillRect(rect(), palette().color(QPalette::Window));
         painter.setPen(palette().color(QPalette::WindowText));
-        QString helpText = "Select two images to compare\nUse mouse wheel to zoom, drag to pan";
+        QString helpText = "Select two images to compare\nUse mouse wheel to zoom, drag to pan"
+                           "\nC: show changes, N/P: next/previous changed region"
+                           "\nL: loupe, [ and ]: loupe magnification";
         if (compareMode == DissolveMode) {
             helpText += "\nDissolve mode: images will fade between each other";
+        } else if (compareMode == DifferenceMode) {
+            helpText += "\nDifference mode: red pixels differ, yellow pixels are anti-aliasing";
+        } else if (compareMode == FlipMode) {
+            helpText += "\nFlip mode: tap Space to switch images, hold it to peek at the other one";
         }
         painter.drawText(rect(), Qt::AlignCenter, helpText);
+        frameScheduler->framePainted();
         return;
     }
     
-    // Scale images to fit the widget while maintaining aspect ratio, then apply zoom
-    QRect widgetRect = rect();
-    scaledFirstImage = scalePixmapToFit(firstImage, widgetRect.size());
-    scaledSecondImage = scalePixmapToFit(secondImage, widgetRect.size());
-    
-    // Apply zoom factor to the scaled images
-    QSize zoomedSize = QSize(
-        static_cast<int>(scaledFirstImage.width() * zoomFactor),
-        static_cast<int>(scaledFirstImage.height() * zoomFactor)
-    );
+    // The image layers are composed on the render thread; paint only blits
+    // the latest finished frame and draws the overlays over it
+    const int generation = renderer->submit(viewState());
+    // Until the render thread has a flip frame, flipping still shows the
+    // first image, and the frame does not count as the one asked for
+    const bool wantFlip = compareMode == FlipMode && flipped;
+    bool showedFlip = false;
+    ViewRenderer::ViewState shown;
+    const bool frameCurrent = renderer->drawFrame(painter, QPoint(0, 0), wantFlip, &showedFlip, &shown) == generation
+                              && showedFlip == wantFlip;
     
-    QPixmap zoomedFirstImage = scaledFirstImage.scaled(zoomedSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-    QPixmap zoomedSecondImage = scaledSecondImage.scaled(zoomedSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    // The frame on screen may trail the current state while a render is in
+    // flight, so the overlays take their geometry from the state it shows
+    const QRect firstRect = shown.targets[shown.base];
     
-    // Calculate the position to center images with pan offset
-    QPoint firstImagePos = QPoint(
-        (widgetRect.width() - zoomedFirstImage.width()) / 2 + panOffset.x(),
-        (widgetRect.height() - zoomedFirstImage.height()) / 2 + panOffset.y()
-    );
-    QPoint secondImagePos = QPoint(
-        (widgetRect.width() - zoomedSecondImage.width()) / 2 + panOffset.x(),
-        (widgetRect.height() - zoomedSecondImage.height()) / 2 + panOffset.y()
-    );
+    // Draw a subtle line to show the reveal boundary
+    if (!shown.revealEdge.isNull()) {
+        painter.setPen(QPen(QColor(255, 255, 255, 180), 2));
+        painter.drawLine(shown.revealEdge);
+    }
     
-    if (compareMode == DissolveMode) {
-        // Draw first image
-        painter.drawPixmap(firstImagePos, zoomedFirstImage);
+    // Draw change map overlay, one translucent cell per changed block
+    if (showChangeOverlay && !changeOverlay.isNull() && !firstRect.isEmpty()) {
+        painter.drawImage(firstRect, changeOverlay);
         
-        // Draw second image with opacity
-        if (currentOpacity > 0.0) {
-            painter.setOpacity(currentOpacity);
-            painter.drawPixmap(secondImagePos, zoomedSecondImage);
-            painter.setOpacity(1.0);
-        }
-    } else {
-        // Wipe mode - original functionality
-        // Draw the first image (base image)
-        painter.drawPixmap(firstImagePos, zoomedFirstImage);
-        
-        // Create clipping region for the second image based on reveal position and direction
-        if (revealPosition > 0.0) {
-            QRect clipRect;
-            
-            if (direction == LeftToRight) {
-                int revealWidth = static_cast<int>(zoomedSecondImage.width() * revealPosition);
-                clipRect = QRect(secondImagePos.x(), secondImagePos.y(), revealWidth, zoomedSecondImage.height());
-            } else if (direction == RightToLeft) {
-                int revealWidth = static_cast<int>(zoomedSecondImage.width() * revealPosition);
-                int startX = secondImagePos.x() + zoomedSecondImage.width() - revealWidth;
-                clipRect = QRect(startX, secondImagePos.y(), revealWidth, zoomedSecondImage.height());
-            } else if (direction == TopToBottom) {
-                int revealHeight = static_cast<int>(zoomedSecondImage.height() * revealPosition);
-                clipRect = QRect(secondImagePos.x(), secondImagePos.y(), zoomedSecondImage.width(), revealHeight);
-            } else { // BottomToTop
-                int revealHeight = static_cast<int>(zoomedSecondImage.height() * revealPosition);
-                int startY = secondImagePos.y() + zoomedSecondImage.height() - revealHeight;
-                clipRect = QRect(secondImagePos.x(), startY, zoomedSecondImage.width(), revealHeight);
-            }
-            
-            // Set clipping region and draw second image
-            painter.setClipRect(clipRect);
-            painter.drawPixmap(secondImagePos, zoomedSecondImage);
-            painter.setClipping(false);
-            
-            // Draw a subtle line to show the reveal boundary
-            painter.setPen(QPen(QColor(255, 255, 255, 180), 2));
-            if (direction == LeftToRight) {
-                int lineX = secondImagePos.x() + static_cast<int>(zoomedSecondImage.width() * revealPosition);
-                painter.drawLine(lineX, secondImagePos.y(), lineX, secondImagePos.y() + zoomedSecondImage.height());
-            } else if (direction == RightToLeft) {
-                int lineX = secondImagePos.x() + zoomedSecondImage.width() - static_cast<int>(zoomedSecondImage.width() * revealPosition);
-                painter.drawLine(lineX, secondImagePos.y(), lineX, secondImagePos.y() + zoomedSecondImage.height());
-            } else if (direction == TopToBottom) {
-                int lineY = secondImagePos.y() + static_cast<int>(zoomedSecondImage.height() * revealPosition);
-                painter.drawLine(secondImagePos.x(), lineY, secondImagePos.x() + zoomedSecondImage.width(), lineY);
-            } else { // BottomToTop
-                int lineY = secondImagePos.y() + zoomedSecondImage.height() - static_cast<int>(zoomedSecondImage.height() * revealPosition);
-                painter.drawLine(secondImagePos.x(), lineY, secondImagePos.x() + zoomedSecondImage.width(), lineY);
-            }
+        // Outline the region navigation is currently focused on
+        QRect regionRect = changeMap.regionImageRect(currentRegion);
+        if (!regionRect.isNull()) {
+            double scaleX = static_cast<double>(firstRect.width()) / changeMap.imageSize().width();
+            double scaleY = static_cast<double>(firstRect.height()) / changeMap.imageSize().height();
+            QRectF outline(firstRect.left() + regionRect.left() * scaleX,
+                           firstRect.top() + regionRect.top() * scaleY,
+                           regionRect.width() * scaleX,
+                           regionRect.height() * scaleY);
+            painter.setPen(QPen(QColor(255, 220, 0), 2));
+            painter.setBrush(Qt::NoBrush);
+            painter.drawRect(outline.adjusted(-2, -2, 2, 2));
         }
     }
     
@@ -187,27 +487,175 @@ void ImageCompareWidget::paintEvent(QPaintEvent *event)
         painter.setPen(QColor(255, 255, 255));
         painter.drawText(dissolveRect, Qt::AlignCenter, "Dissolving...");
     }
+    
+    // Draw which image flip mode is showing
+    if (compareMode == FlipMode) {
+        painter.setPen(QPen(QColor(255, 255, 255, 200), 1));
+        painter.setBrush(QBrush(QColor(0, 0, 0, 100)));
+        QRect flipRect(10, 40, 120, 25);
+        painter.drawRoundedRect(flipRect, 5, 5);
+        painter.setPen(QColor(255, 255, 255));
+        painter.drawText(flipRect, Qt::AlignCenter, showedFlip ? "Second image" : "First image");
+    }
+    
+    // Draw difference summary; saved full-resolution counts take precedence
+    // over counts from a preview
+    const bool savedCounts = savedMetricsApply();
+    if (compareMode == DifferenceMode && (!differenceImage.isNull() || savedCounts)) {
+        painter.setPen(QPen(QColor(255, 255, 255, 200), 1));
+        painter.setBrush(QBrush(QColor(0, 0, 0, 100)));
+        QRect differenceRect(10, 40, 260, 25);
+        painter.drawRoundedRect(differenceRect, 5, 5);
+        painter.setPen(QColor(255, 255, 255));
+        const qint64 differentPixels = savedCounts ? savedMetrics.differentPixels : differenceResult.differentPixels;
+        const qint64 antiAliasedPixels = savedCounts ? savedMetrics.antiAliasedPixels : differenceResult.antiAliasedPixels;
+        QString differenceText = QString("%1 pixels differ").arg(differentPixels);
+        if (!differenceOptions.includeAntiAliasing) {
+            differenceText += QString(", %1 anti-aliased").arg(antiAliasedPixels);
+        }
+        painter.drawText(differenceRect, Qt::AlignCenter, differenceText);
+    }
+    
+    // Draw change navigation indicator
+    if (showChangeOverlay) {
+        painter.setPen(QPen(QColor(255, 255, 255, 200), 1));
+        painter.setBrush(QBrush(QColor(0, 0, 0, 100)));
+        QRect changeRect(10, 70, 140, 25);
+        painter.drawRoundedRect(changeRect, 5, 5);
+        painter.setPen(QColor(255, 255, 255));
+        QString changeText;
+        if (changeMap.regions().isEmpty()) {
+            changeText = "No changes";
+        } else if (currentRegion < 0) {
+            changeText = QString("%1 changed regions").arg(changeMap.regions().size());
+        } else {
+            changeText = QString("Change %1 of %2").arg(currentRegion + 1).arg(changeMap.regions().size());
+        }
+        painter.drawText(changeRect, Qt::AlignCenter, changeText);
+    }
+    
+    // Draw input latency readout
+    if (showFrameStats) {
+        const FrameScheduler::Stats stats = frameScheduler->stats();
+        painter.setPen(QPen(QColor(255, 255, 255, 200), 1));
+        painter.setBrush(QBrush(QColor(0, 0, 0, 100)));
+        QRect statsRect(10, 100, 300, 25);
+        painter.drawRoundedRect(statsRect, 5, 5);
+        painter.setPen(QColor(255, 255, 255));
+        painter.drawText(statsRect, Qt::AlignCenter,
+                         QString("Latency %1 ms avg, %2 max / %3 ms frame")
+                             .arg(stats.averageLatencyMs, 0, 'f', 1)
+                             .arg(stats.maxLatencyMs, 0, 'f', 1)
+                             .arg(stats.frameIntervalMs, 0, 'f', 1));
+    }
+    
+    if (showInfoPanel) {
+        drawInfoPanel(painter);
+    }
+    
+    // Draw loupe last so it sits above every other overlay
+    if (loupeEnabled) {
+        drawLoupe(painter, firstRect);
+    }
+    
+    // Input and load timings count once the frame showing them is on screen
+    if (!frameCurrent) return;
+    
+    if (!firstPixelsReported) {
+        firstPixelsReported = true;
+        reportLoadTiming(QString("First pixels (%1)").arg(
+            firstIsFullResolution && secondIsFullResolution ? "full decode" : previewSource));
+    }
+    
+    frameScheduler->framePainted();
 }
 
-void ImageCompareWidget::mouseMoveEvent(QMouseEvent *event)
+ViewRenderer::ViewState ImageCompareWidget::viewState() const
 {
-    if (hasImages) {
-        if (isPanning && (event->buttons() & Qt::LeftButton)) {
-            // Handle panning
-            QPoint delta = event->pos() - lastPanPoint;
-            panOffset += delta;
-            lastPanPoint = event->pos();
-            update();
-        } else {
-            // Handle image comparison reveal
-            updateRevealPosition(event->pos());
+    ViewRenderer::ViewState state;
+    state.size = size();
+    
+    if (compareMode == DifferenceMode && !differenceImage.isNull()) {
+        // The perceptual difference is drawn in place of both images
+        state.base = ViewRenderer::DifferenceLayer;
+        state.images[ViewRenderer::DifferenceLayer] = differenceImage;
+        state.targets[ViewRenderer::DifferenceLayer] = displayRect(differenceImage);
+        return state;
+    }
+    
+    state.base = ViewRenderer::FirstLayer;
+    state.images[ViewRenderer::FirstLayer] = firstImage;
+    state.targets[ViewRenderer::FirstLayer] = displayRect(firstImage);
+    state.images[ViewRenderer::SecondLayer] = secondImage;
+    state.targets[ViewRenderer::SecondLayer] = displayRect(secondImage);
+    if (compareMode == FlipMode) {
+        // Each image in a frame of its own; which one shows is not part of
+        // the state, so flipping never waits for a render
+        state.flip = ViewRenderer::SecondLayer;
+        return state;
+    }
+    
+    state.overlay = ViewRenderer::SecondLayer;
+    if (compareMode == DissolveMode) {
+        // Second image over the first with the dissolve opacity
+        state.overlayClip = rect();
+        state.overlayOpacity = currentOpacity;
+    } else {
+        // Second image revealed up to the wipe position, with a line along
+        // the boundary
+        const QRect secondRect = state.targets[ViewRenderer::SecondLayer];
+        const QRect clipRect = revealRect(secondRect);
+        state.overlayClip = clipRect;
+        if (revealPosition > 0.0) {
+            if (direction == LeftToRight) {
+                state.revealEdge = QLine(clipRect.x() + clipRect.width(), secondRect.y(),
+                                         clipRect.x() + clipRect.width(), secondRect.y() + secondRect.height());
+            } else if (direction == RightToLeft) {
+                state.revealEdge = QLine(clipRect.x(), secondRect.y(), clipRect.x(), secondRect.y() + secondRect.height());
+            } else if (direction == TopToBottom) {
+                state.revealEdge = QLine(secondRect.x(), clipRect.y() + clipRect.height(),
+                                         secondRect.x() + secondRect.width(), clipRect.y() + clipRect.height());
+            } else { // BottomToTop
+                state.revealEdge = QLine(secondRect.x(), clipRect.y(), secondRect.x() + secondRect.width(), clipRect.y());
+            }
         }
     }
+    return state;
+}
+
+QRect ImageCompareWidget::revealRect(const QRect &secondRect) const
+{
+    if (revealPosition <= 0.0) return QRect();
+    
+    if (direction == LeftToRight) {
+        int revealWidth = static_cast<int>(secondRect.width() * revealPosition);
+        return QRect(secondRect.x(), secondRect.y(), revealWidth, secondRect.height());
+    } else if (direction == RightToLeft) {
+        int revealWidth = static_cast<int>(secondRect.width() * revealPosition);
+        int startX = secondRect.x() + secondRect.width() - revealWidth;
+        return QRect(startX, secondRect.y(), revealWidth, secondRect.height());
+    } else if (direction == TopToBottom) {
+        int revealHeight = static_cast<int>(secondRect.height() * revealPosition);
+        return QRect(secondRect.x(), secondRect.y(), secondRect.width(), revealHeight);
+    } else { // BottomToTop
+        int revealHeight = static_cast<int>(secondRect.height() * revealPosition);
+        int startY = secondRect.y() + secondRect.height() - revealHeight;
+        return QRect(secondRect.x(), startY, secondRect.width(), revealHeight);
+    }
+}
+
+void ImageCompareWidget::mouseMoveEvent(QMouseEvent *event)
+{
+    // Only the latest position matters; it is applied when the frame is due
+    pendingMousePos = event->pos();
+    mouseMovePending = true;
+    frameScheduler->requestFrame();
     QWidget::mouseMoveEvent(event);
 }
 
 void ImageCompareWidget::mousePressEvent(QMouseEvent *event)
 {
+    applyPendingInput();
     if (hasImages && event->button() == Qt::LeftButton) {
         isPanning = true;
         lastPanPoint = event->pos();
@@ -219,6 +667,8 @@ void ImageCompareWidget::mousePressEvent(QMouseEvent *event)
 void ImageCompareWidget::mouseReleaseEvent(QMouseEvent *event)
 {
     if (event->button() == Qt::LeftButton) {
+        // Finish the drag where the button came up
+        applyPendingInput();
         isPanning = false;
         setCursor(Qt::ArrowCursor);
     }
@@ -227,22 +677,32 @@ void ImageCompareWidget::mouseReleaseEvent(QMouseEvent *event)
 
 void ImageCompareWidget::wheelEvent(QWheelEvent *event)
 {
-    if (hasImages) {
-        // Get the mouse position for zoom center
-        QPoint mousePos = event->position().toPoint();
+    if (hasImages && event->angleDelta().y() != 0) {
+        // Notches arriving within one frame are applied together
+        pendingZoomSteps += (event->angleDelta().y() > 0) ? 1 : -1;
+        pendingZoomCenter = event->position().toPoint();
+        frameScheduler->requestFrame();
+    }
+    QWidget::wheelEvent(event);
+}
+
+void ImageCompareWidget::applyPendingInput()
+{
+    if (pendingZoomSteps != 0) {
+        const int steps = pendingZoomSteps;
+        pendingZoomSteps = 0;
         
         // Calculate zoom change
-        double zoomChange = (event->angleDelta().y() > 0) ? ZOOM_STEP : (1.0 / ZOOM_STEP);
-        double newZoomFactor = zoomFactor * zoomChange;
+        double newZoomFactor = zoomFactor * std::pow(ZOOM_STEP, steps);
         
         // Clamp zoom factor
         newZoomFactor = qBound(MIN_ZOOM, newZoomFactor, MAX_ZOOM);
         
-        if (newZoomFactor != zoomFactor) {
+        if (hasImages && newZoomFactor != zoomFactor) {
             // Calculate the point in image coordinates before zoom
             QRect widgetRect = rect();
             QPoint imageCenter = QPoint(widgetRect.width() / 2, widgetRect.height() / 2);
-            QPoint mouseRelativeToCenter = mousePos - imageCenter;
+            QPoint mouseRelativeToCenter = pendingZoomCenter - imageCenter;
             QPoint adjustedMousePos = mouseRelativeToCenter - panOffset;
             
             // Apply zoom
@@ -255,11 +715,47 @@ void ImageCompareWidget::wheelEvent(QWheelEvent *event)
                 static_cast<int>(adjustedMousePos.y() * zoomRatio)
             );
             panOffset += adjustedMousePos - newMousePos;
-            
-            update();
         }
     }
-    QWidget::wheelEvent(event);
+    
+    if (mouseMovePending) {
+        mouseMovePending = false;
+        loupeCursor = pendingMousePos;
+        if (hasImages) {
+            if (isPanning && (QGuiApplication::mouseButtons() & Qt::LeftButton)) {
+                // Handle panning
+                QPoint delta = pendingMousePos - lastPanPoint;
+                panOffset += delta;
+                lastPanPoint = pendingMousePos;
+            } else {
+                // Handle image comparison reveal
+                updateRevealPosition(pendingMousePos);
+            }
+        }
+    }
+}
+
+FrameScheduler::Stats ImageCompareWidget::frameStats() const
+{
+    return frameScheduler->stats();
+}
+
+void ImageCompareWidget::setFrameStatsVisible(bool visible)
+{
+    if (visible && !showFrameStats) {
+        frameScheduler->resetStats();
+    } else if (!visible && showFrameStats) {
+        const FrameScheduler::Stats stats = frameScheduler->stats();
+        qInfo().noquote() << QString("Input latency over %1 frames: %2 ms average, %3 ms worst, "
+                                     "%4 ms frame interval, %5 inputs coalesced")
+                                 .arg(stats.frames)
+                                 .arg(stats.averageLatencyMs, 0, 'f', 1)
+                                 .arg(stats.maxLatencyMs, 0, 'f', 1)
+                                 .arg(stats.frameIntervalMs, 0, 'f', 1)
+                                 .arg(stats.coalescedInputs);
+    }
+    showFrameStats = visible;
+    update();
 }
 
 void ImageCompareWidget::keyPressEvent(QKeyEvent *event)
@@ -276,6 +772,45 @@ void ImageCompareWidget::keyPressEvent(QKeyEvent *event)
             case Qt::Key_0:
                 resetZoom();
                 break;
+            case Qt::Key_C:
+                setChangeOverlayVisible(!showChangeOverlay);
+                break;
+            case Qt::Key_N:
+                if (event->modifiers() & Qt::ShiftModifier) {
+                    previousChangedRegion();
+                } else {
+                    nextChangedRegion();
+                }
+                break;
+            case Qt::Key_P:
+                previousChangedRegion();
+                break;
+            case Qt::Key_L:
+                setLoupeEnabled(!loupeEnabled);
+                break;
+            case Qt::Key_BracketRight:
+                setLoupeMagnification(loupeMagnification * 2);
+                break;
+            case Qt::Key_BracketLeft:
+                setLoupeMagnification(loupeMagnification / 2);
+                break;
+            case Qt::Key_F:
+                setFrameStatsVisible(!showFrameStats);
+                break;
+            case Qt::Key_I:
+                setInfoPanelVisible(!showInfoPanel);
+                break;
+            case Qt::Key_Space:
+                if (compareMode != FlipMode) {
+                    QWidget::keyPressEvent(event);
+                    return;
+                }
+                // Auto-repeat while held changes nothing
+                if (!event->isAutoRepeat()) {
+                    flipPressTimer.start();
+                    setFlipped(!flipped);
+                }
+                break;
             default:
                 QWidget::keyPressEvent(event);
                 return;
@@ -286,10 +821,37 @@ void ImageCompareWidget::keyPressEvent(QKeyEvent *event)
     }
 }
 
+void ImageCompareWidget::keyReleaseEvent(QKeyEvent *event)
+{
+    if (event->key() != Qt::Key_Space || compareMode != FlipMode) {
+        QWidget::keyReleaseEvent(event);
+        return;
+    }
+    
+    // A tap leaves the other image up; a hold was a peek and flips back
+    if (!event->isAutoRepeat() && flipPressTimer.isValid() && flipPressTimer.elapsed() >= FLIP_HOLD_MS) {
+        setFlipped(!flipped);
+    }
+    flipPressTimer.invalidate();
+    event->accept();
+}
+
+void ImageCompareWidget::setFlipped(bool newFlipped)
+{
+    if (flipped == newFlipped) return;
+    flipped = newFlipped;
+    
+    // Both frames are already composed, so paint now rather than waiting
+    // for the next paced frame
+    repaint();
+}
+
 void ImageCompareWidget::leaveEvent(QEvent *event)
 {
     // Reset reveal position when mouse leaves the widget
     revealPosition = 0.0;
+    loupeCursor = QPoint(-1, -1);
+    mouseMovePending = false;
     isPanning = false;
     setCursor(Qt::ArrowCursor);
     update();
@@ -301,17 +863,7 @@ void ImageCompareWidget::updateRevealPosition(const QPoint &mousePos)
     if (!hasImages) return;
     
     // Calculate the zoomed image bounds with pan offset
-    QRect widgetRect = rect();
-    QSize zoomedSize = QSize(
-        static_cast<int>(scaledFirstImage.width() * zoomFactor),
-        static_cast<int>(scaledFirstImage.height() * zoomFactor)
-    );
-    
-    QPoint imagePos = QPoint(
-        (widgetRect.width() - zoomedSize.width()) / 2 + panOffset.x(),
-        (widgetRect.height() - zoomedSize.height()) / 2 + panOffset.y()
-    );
-    QRect imageRect(imagePos, zoomedSize);
+    QRect imageRect = displayRect(firstImage);
     
     // Check if mouse is within image bounds
     if (!imageRect.contains(mousePos)) {
@@ -338,20 +890,123 @@ void ImageCompareWidget::updateRevealPosition(const QPoint &mousePos)
     update(); // Trigger repaint
 }
 
-QPixmap ImageCompareWidget::scalePixmapToFit(const QPixmap &pixmap, const QSize &targetSize) const
+QRect ImageCompareWidget::displayRect(const QImage &image) const
 {
-    if (pixmap.isNull()) return QPixmap();
+    if (image.isNull()) return QRect();
     
-    // Scale pixmap to fit within target size while maintaining aspect ratio
-    return pixmap.scaled(targetSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    // Fit the widget while maintaining aspect ratio, apply zoom, then center
+    // with the pan offset
+    QSize fitted = image.size().scaled(rect().size(), Qt::KeepAspectRatio);
+    QSize zoomedSize(static_cast<int>(fitted.width() * zoomFactor),
+                     static_cast<int>(fitted.height() * zoomFactor));
+    QPoint position((width() - zoomedSize.width()) / 2 + panOffset.x(),
+                    (height() - zoomedSize.height()) / 2 + panOffset.y());
+    return QRect(position, zoomedSize);
 }
 
-QPixmap ImageCompareWidget::scalePixmapToFill(const QPixmap &pixmap, const QSize &targetSize) const
+QImage ImageCompareWidget::scaleImageToFill(const QImage &image, const QSize &targetSize) const
 {
-    if (pixmap.isNull()) return QPixmap();
+    if (image.isNull()) return QImage();
     
-    // Scale pixmap to fill target size while maintaining aspect ratio (may crop)
-    return pixmap.scaled(targetSize, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+    // Scale image to fill target size while maintaining aspect ratio (may crop)
+    return Resampler::scale(image, image.size().scaled(targetSize, Qt::KeepAspectRatioByExpanding));
+}
+
+qint64 ImageCompareWidget::imageBytes(int side) const
+{
+    return (side == 0 ? firstImage : secondImage).sizeInBytes();
+}
+
+QImage::Format ImageCompareWidget::imageFormat(int side) const
+{
+    return (side == 0 ? firstImage : secondImage).format();
+}
+
+ImageStats ImageCompareWidget::imageStats(int side) const
+{
+    return side == 0 ? firstStats : secondStats;
+}
+
+void ImageCompareWidget::setInfoPanelVisible(bool visible)
+{
+    showInfoPanel = visible;
+    startStats();
+    update();
+}
+
+void ImageCompareWidget::drawInfoPanel(QPainter &painter)
+{
+    const int lineHeight = painter.fontMetrics().height();
+    const int histogramHeight = 40;
+    const int sideHeight = 3 * lineHeight + histogramHeight + 10;
+    QRect panel(width() - INFO_PANEL_WIDTH - 10, 10, INFO_PANEL_WIDTH, 2 * sideHeight + lineHeight + 20);
+    
+    painter.save();
+    painter.setPen(QPen(QColor(255, 255, 255, 200), 1));
+    painter.setBrush(QBrush(QColor(0, 0, 0, 160)));
+    painter.drawRoundedRect(panel, 5, 5);
+    
+    const QImage *images[2] = {&firstImage, &secondImage};
+    const ImageStats *stats[2] = {&firstStats, &secondStats};
+    int y = panel.top() + 8;
+    for (int side = 0; side < 2; ++side) {
+        const QRect line(panel.left() + 10, y, panel.width() - 20, lineHeight);
+        painter.setPen(QColor(255, 255, 255));
+        painter.drawText(line, Qt::AlignLeft | Qt::AlignVCenter,
+                         QString("%1: %2\u00d7%3").arg(side == 0 ? "First" : "Second")
+                             .arg(images[side]->width()).arg(images[side]->height()));
+        
+        const ImageStats &info = *stats[side];
+        if (!info.isValid()) {
+            painter.drawText(line.translated(0, lineHeight), Qt::AlignLeft | Qt::AlignVCenter, "Loading...");
+            y += sideHeight;
+            continue;
+        }
+        
+        // Value range and mean per channel, greyscale images as one
+        QString range;
+        if (info.grayscale) {
+            range = QString("Gray %1-%2, mean %3").arg(info.minimum[ImageStats::Luma])
+                        .arg(info.maximum[ImageStats::Luma]).arg(info.mean[ImageStats::Luma], 0, 'f', 1);
+        } else {
+            const char *names[3] = {"R", "G", "B"};
+            for (int channel = ImageStats::Red; channel <= ImageStats::Blue; ++channel) {
+                range += QString("%1 %2-%3 (%4)  ").arg(names[channel]).arg(info.minimum[channel])
+                             .arg(info.maximum[channel]).arg(info.mean[channel], 0, 'f', 0);
+            }
+        }
+        painter.drawText(line.translated(0, lineHeight), Qt::AlignLeft | Qt::AlignVCenter, range.trimmed());
+        painter.drawText(line.translated(0, 2 * lineHeight), Qt::AlignLeft | Qt::AlignVCenter,
+                         QString("Hash %1%2").arg(info.contentHash, 16, 16, QChar('0'))
+                             .arg(info.opaque ? "" : ", has alpha"));
+        
+        // Luma histogram scaled to its tallest bin
+        const QRect histogram(line.left(), y + 3 * lineHeight + 4, 256, histogramHeight);
+        qint64 peak = 1;
+        for (int value = 0; value < 256; ++value) {
+            peak = qMax(peak, info.histogram[ImageStats::Luma][value]);
+        }
+        painter.fillRect(histogram, QColor(255, 255, 255, 30));
+        painter.setPen(QColor(220, 220, 220));
+        for (int value = 0; value < 256; ++value) {
+            const int barHeight = static_cast<int>(info.histogram[ImageStats::Luma][value] * histogramHeight / peak);
+            if (barHeight > 0) {
+                painter.drawLine(histogram.left() + value, histogram.bottom(),
+                                 histogram.left() + value, histogram.bottom() - barHeight + 1);
+            }
+        }
+        y += sideHeight;
+    }
+    
+    // Equal hashes mean the decoded pixels match, whatever the files look like
+    if (firstStats.isValid() && secondStats.isValid()) {
+        const bool same = firstStats.contentHash == secondStats.contentHash;
+        painter.setPen(same ? QColor(120, 220, 120) : QColor(255, 255, 255));
+        painter.drawText(QRect(panel.left() + 10, y, panel.width() - 20, lineHeight),
+                         Qt::AlignLeft | Qt::AlignVCenter,
+                         same ? "Identical pixels" : "Pixels differ");
+    }
+    painter.restore();
 }
 
 void ImageCompareWidget::resetZoom()
@@ -361,6 +1016,19 @@ void ImageCompareWidget::resetZoom()
     update();
 }
 
+void ImageCompareWidget::setZoomFactor(double factor)
+{
+    double newZoomFactor = qBound(MIN_ZOOM, factor, MAX_ZOOM);
+    
+    // Scale the pan offset with the zoom so the view stays centred on the same point
+    panOffset = QPoint(
+        static_cast<int>(panOffset.x() * newZoomFactor / zoomFactor),
+        static_cast<int>(panOffset.y() * newZoomFactor / zoomFactor)
+    );
+    zoomFactor = newZoomFactor;
+    update();
+}
+
 void ImageCompareWidget::zoomIn()
 {
     double newZoomFactor = zoomFactor * ZOOM_STEP;
@@ -379,6 +1047,234 @@ void ImageCompareWidget::zoomOut()
     }
 }
 
+double ImageCompareWidget::fitScale() const
+{
+    if (firstImage.isNull()) return 1.0;
+    
+    // Same scale displayRect applies before zoom
+    QSize fitted = firstImage.size().scaled(rect().size(), Qt::KeepAspectRatio);
+    return static_cast<double>(fitted.width()) / firstImage.width();
+}
+
+void ImageCompareWidget::setChangeOverlayVisible(bool visible)
+{
+    showChangeOverlay = visible;
+    update();
+}
+
+void ImageCompareWidget::nextChangedRegion()
+{
+    int count = changeMap.regions().size();
+    if (count == 0) return;
+    focusChangedRegion((currentRegion + 1) % count);
+}
+
+void ImageCompareWidget::previousChangedRegion()
+{
+    int count = changeMap.regions().size();
+    if (count == 0) return;
+    focusChangedRegion(currentRegion <= 0 ? count - 1 : currentRegion - 1);
+}
+
+void ImageCompareWidget::focusChangedRegion(int index)
+{
+    QRect regionRect = changeMap.regionImageRect(index);
+    if (regionRect.isNull() || !hasImages) return;
+    
+    currentRegion = index;
+    showChangeOverlay = true;
+    
+    // Regions are stored in change map pixels; convert to the displayed image
+    double mapToImage = static_cast<double>(firstImage.width()) / changeMap.imageSize().width();
+    double regionWidth = regionRect.width() * mapToImage;
+    double regionHeight = regionRect.height() * mapToImage;
+    QPointF regionCenter = QRectF(regionRect).center() * mapToImage;
+    
+    // Zoom so the region fills a fixed share of the view, never zooming out past fit
+    double baseScale = fitScale();
+    double zoomX = width() * REGION_VIEW_FRACTION / (regionWidth * baseScale);
+    double zoomY = height() * REGION_VIEW_FRACTION / (regionHeight * baseScale);
+    zoomFactor = qBound(1.0, qMin(zoomX, zoomY), MAX_ZOOM);
+    
+    // Pan so the region center lands on the widget center
+    double scale = baseScale * zoomFactor;
+    panOffset = QPoint(
+        static_cast<int>((firstImage.width() / 2.0 - regionCenter.x()) * scale),
+        static_cast<int>((firstImage.height() / 2.0 - regionCenter.y()) * scale)
+    );
+    
+    update();
+}
+
+void ImageCompareWidget::setLoupeEnabled(bool enabled)
+{
+    loupeEnabled = enabled;
+    
+    // The buffer is allocated once and refilled in place on every mouse move
+    if (loupeEnabled && loupeBuffer.isNull()) {
+        loupeBuffer = QImage(LOUPE_SIZE, LOUPE_SIZE, QImage::Format_ARGB32_Premultiplied);
+    }
+    update();
+}
+
+void ImageCompareWidget::setLoupeMagnification(int magnification)
+{
+    loupeMagnification = qBound(1, magnification, MAX_LOUPE_MAGNIFICATION);
+    update();
+}
+
+void ImageCompareWidget::renderLoupe(const QRect &imageRect)
+{
+    const int half = LOUPE_SIZE / 2;
+    const QRgb outside = qRgb(32, 32, 32);
+    
+    // Cursor in first-image source pixels; both images are addressed through
+    // normalized coordinates so a differently sized second image lines up
+    const double cursorU = static_cast<double>(loupeCursor.x() - imageRect.left()) / imageRect.width();
+    const double cursorV = static_cast<double>(loupeCursor.y() - imageRect.top()) / imageRect.height();
+    const double centerX = cursorU * firstImage.width();
+    const double centerY = cursorV * firstImage.height();
+    const double secondScaleX = static_cast<double>(secondImage.width()) / firstImage.width();
+    const double secondScaleY = static_cast<double>(secondImage.height()) / firstImage.height();
+    const bool horizontalWipe = (direction == LeftToRight || direction == RightToLeft);
+    
+    for (int x = 0; x < LOUPE_SIZE; ++x) {
+        const double sourceX = centerX + static_cast<double>(x - half) / loupeMagnification;
+        const double u = sourceX / firstImage.width();
+        bool inside = (sourceX >= 0.0 && sourceX < firstImage.width());
+        loupeFirstColumns[x] = inside ? static_cast<int>(sourceX) : -1;
+        loupeSecondColumns[x] = inside ? qMin(static_cast<int>(sourceX * secondScaleX), secondImage.width() - 1) : -1;
+        loupeColumnSide[x] = (direction == LeftToRight) ? (u < revealPosition)
+                           : (direction == RightToLeft) ? (u > 1.0 - revealPosition) : 0;
+    }
+    
+    // Dissolve blends both sources by the current opacity, 0-256 fixed point;
+    // flip mode is the same blend at 0 or 1
+    const bool dissolving = (compareMode == DissolveMode || compareMode == FlipMode);
+    const double secondShare = (compareMode == FlipMode) ? (flipped ? 1.0 : 0.0) : currentOpacity;
+    const uint secondWeight = static_cast<uint>(secondShare * 256.0);
+    const uint firstWeight = 256 - secondWeight;
+    
+    // Difference mode magnifies the difference image, which matches the first image's size
+    // A difference image still standing in for a previous size is not used
+    const bool differencing = (compareMode == DifferenceMode && !differenceImage.isNull()
+                               && differenceImage.size() == firstImage.size());
+    const QImage &baseImage = differencing ? differenceImage : firstImage;
+    
+    // Convert just the source pixels the loupe covers, whatever format the
+    // images are stored in
+    int firstLeft = firstImage.width();
+    int firstRight = -1;
+    int secondLeft = secondImage.width();
+    int secondRight = -1;
+    for (int x = 0; x < LOUPE_SIZE; ++x) {
+        if (loupeFirstColumns.at(x) < 0) continue;
+        firstLeft = qMin(firstLeft, loupeFirstColumns.at(x));
+        firstRight = qMax(firstRight, loupeFirstColumns.at(x));
+        secondLeft = qMin(secondLeft, loupeSecondColumns.at(x));
+        secondRight = qMax(secondRight, loupeSecondColumns.at(x));
+    }
+    const int firstTop = qMax(0, static_cast<int>(centerY - static_cast<double>(half) / loupeMagnification));
+    const int firstBottom = qMin(firstImage.height() - 1,
+        static_cast<int>(centerY + static_cast<double>(LOUPE_SIZE - 1 - half) / loupeMagnification));
+    const int secondTop = qMin(secondImage.height() - 1, static_cast<int>(firstTop * secondScaleY));
+    const int secondBottom = qMin(secondImage.height() - 1, static_cast<int>((firstBottom + 1) * secondScaleY));
+    if (firstRight < 0 || firstBottom < firstTop) {
+        loupeBuffer.fill(outside);
+        return;
+    }
+    const QRect firstPatchRect(QPoint(firstLeft, firstTop), QPoint(firstRight, firstBottom));
+    const QRect secondPatchRect(QPoint(secondLeft, secondTop), QPoint(secondRight, secondBottom));
+    const QImage firstPatch = baseImage.copy(firstPatchRect).convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    const QImage secondPatch = secondImage.copy(secondPatchRect).convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    
+    for (int y = 0; y < LOUPE_SIZE; ++y) {
+        QRgb *out = reinterpret_cast<QRgb *>(loupeBuffer.scanLine(y));
+        const double sourceY = centerY + static_cast<double>(y - half) / loupeMagnification;
+        if (sourceY < 0.0 || sourceY >= firstImage.height()) {
+            std::fill(out, out + LOUPE_SIZE, outside);
+            continue;
+        }
+        
+        const double v = sourceY / firstImage.height();
+        const uchar rowSide = (direction == TopToBottom) ? (v < revealPosition)
+                            : (direction == BottomToTop) ? (v > 1.0 - revealPosition) : 0;
+        const int firstY = qBound(firstTop, static_cast<int>(sourceY), firstBottom) - firstTop;
+        const int secondY = qBound(secondTop, static_cast<int>(sourceY * secondScaleY), secondBottom) - secondTop;
+        const QRgb *firstLine = reinterpret_cast<const QRgb *>(firstPatch.constScanLine(firstY));
+        const QRgb *secondLine = reinterpret_cast<const QRgb *>(secondPatch.constScanLine(secondY));
+        
+        for (int x = 0; x < LOUPE_SIZE; ++x) {
+            const int firstX = loupeFirstColumns.at(x) - firstLeft;
+            const int secondX = loupeSecondColumns.at(x) - secondLeft;
+            if (firstX < 0) {
+                out[x] = outside;
+            } else if (differencing) {
+                out[x] = firstLine[firstX];
+            } else if (dissolving) {
+                const QRgb a = firstLine[firstX];
+                const QRgb b = secondLine[secondX];
+                // Blend red/blue and alpha/green pairs two channels at a time
+                const uint rb = (((a & 0x00ff00ff) * firstWeight + (b & 0x00ff00ff) * secondWeight) >> 8) & 0x00ff00ff;
+                const uint ag = ((((a >> 8) & 0x00ff00ff) * firstWeight + ((b >> 8) & 0x00ff00ff) * secondWeight)) & 0xff00ff00;
+                out[x] = rb | ag;
+            } else {
+                const bool showSecond = horizontalWipe ? loupeColumnSide.at(x) : rowSide;
+                out[x] = showSecond ? secondLine[secondX] : firstLine[firstX];
+            }
+        }
+    }
+}
+
+void ImageCompareWidget::drawLoupe(QPainter &painter, const QRect &imageRect)
+{
+    if (!rect().contains(loupeCursor) || imageRect.isEmpty() || loupeBuffer.isNull()) return;
+    
+    renderLoupe(imageRect);
+    
+    // Sit below-right of the cursor, flipping sides near the widget edges
+    QPoint topLeft = loupeCursor + QPoint(LOUPE_OFFSET, LOUPE_OFFSET);
+    if (topLeft.x() + LOUPE_SIZE > width()) {
+        topLeft.setX(loupeCursor.x() - LOUPE_OFFSET - LOUPE_SIZE);
+    }
+    if (topLeft.y() + LOUPE_SIZE > height()) {
+        topLeft.setY(loupeCursor.y() - LOUPE_OFFSET - LOUPE_SIZE);
+    }
+    QRect loupeRect(topLeft, QSize(LOUPE_SIZE, LOUPE_SIZE));
+    
+    painter.drawImage(loupeRect.topLeft(), loupeBuffer);
+    
+    // Wipe boundary inside the loupe
+    if (compareMode == WipeMode && revealPosition > 0.0) {
+        painter.setPen(QPen(QColor(255, 255, 255, 180), 1));
+        if (direction == LeftToRight || direction == RightToLeft) {
+            for (int x = 1; x < LOUPE_SIZE; ++x) {
+                if (loupeColumnSide.at(x) != loupeColumnSide.at(x - 1)) {
+                    painter.drawLine(loupeRect.left() + x, loupeRect.top(), loupeRect.left() + x, loupeRect.bottom());
+                    break;
+                }
+            }
+        } else {
+            int lineY = loupeRect.top() + LOUPE_SIZE / 2;
+            painter.drawLine(loupeRect.left(), lineY, loupeRect.right(), lineY);
+        }
+    }
+    
+    // Frame, centre pixel marker and magnification label
+    painter.setBrush(Qt::NoBrush);
+    painter.setPen(QPen(QColor(255, 255, 255, 200), 1));
+    painter.drawRect(loupeRect.adjusted(0, 0, -1, -1));
+    int center = LOUPE_SIZE / 2;
+    painter.drawRect(loupeRect.left() + center, loupeRect.top() + center, loupeMagnification, loupeMagnification);
+    
+    QRect labelRect(loupeRect.left() + 4, loupeRect.top() + 4, 40, 18);
+    painter.setBrush(QBrush(QColor(0, 0, 0, 100)));
+    painter.setPen(Qt::NoPen);
+    painter.drawRoundedRect(labelRect, 4, 4);
+    painter.setPen(QColor(255, 255, 255));
+    painter.drawText(labelRect, Qt::AlignCenter, QString("%1:1").arg(loupeMagnification));
+}
+
 void ImageCompareWidget::updateImageTransforms()
 {
     // This method can be used for future enhancements
@@ -389,18 +1285,7 @@ QPoint ImageCompareWidget::mapToImageCoordinates(const QPoint &widgetPos) const
 {
     if (!hasImages) return QPoint();
     
-    QRect widgetRect = rect();
-    QSize zoomedSize = QSize(
-        static_cast<int>(scaledFirstImage.width() * zoomFactor),
-        static_cast<int>(scaledFirstImage.height() * zoomFactor)
-    );
-    
-    QPoint imagePos = QPoint(
-        (widgetRect.width() - zoomedSize.width()) / 2 + panOffset.x(),
-        (widgetRect.height() - zoomedSize.height()) / 2 + panOffset.y()
-    );
-    
-    return widgetPos - imagePos;
+    return widgetPos - displayRect(firstImage).topLeft();
 }
 
 void ImageCompareWidget::setCompareMode(CompareMode mode)
@@ -416,11 +1301,77 @@ void ImageCompareWidget::setCompareMode(CompareMode mode)
         // Reset states
         revealPosition = 0.0;
         currentOpacity = 0.0;
+        flipped = false;
+        updateDifferenceImage();
         
         update();
     }
 }
 
+void ImageCompareWidget::setDifferenceSettings(const PerceptualDiff::Options &options)
+{
+    differenceOptions = options;
+    invalidateDifference();
+    updateDifferenceImage();
+    update();
+}
+
+void ImageCompareWidget::invalidateDifference()
+{
+    // The current difference image stays up until its replacement lands
+    ++differenceGeneration;
+}
+
+void ImageCompareWidget::updateDifferenceImage()
+{
+    // Computed on demand, so wipe and dissolve never pay for it; a compare
+    // already running restarts with the latest inputs when it finishes
+    if (compareMode != DifferenceMode || !hasImages || differenceRunning
+        || differenceImageGeneration == differenceGeneration) return;
+    
+    differenceRunning = true;
+    const int generation = differenceGeneration;
+    const QImage first = firstImage;
+    const QImage second = secondImage;
+    const PerceptualDiff::Options options = differenceOptions;
+    
+    QFutureWatcher<Difference> *watcher = new QFutureWatcher<Difference>(this);
+    connect(watcher, &QFutureWatcher<Difference>::finished, this, [this, watcher, generation]() {
+        const Difference difference = watcher->result();
+        watcher->deleteLater();
+        differenceRunning = false;
+        
+        // Inputs changed while comparing: start again from the current ones
+        if (generation != differenceGeneration) {
+            updateDifferenceImage();
+            return;
+        }
+        differenceImage = difference.image;
+        differenceResult = difference.result;
+        differenceImageGeneration = generation;
+        update();
+    });
+    watcher->setFuture(QtConcurrent::run([first, second, options]() {
+        // A second image of another size (or a preview at another scale) is
+        // compared at the first image's size
+        QImage scaled = second;
+        if (scaled.size() != first.size()) {
+            scaled = Resampler::scale(second, first.size());
+        }
+        Difference difference;
+        difference.result = PerceptualDiff::compare(first, scaled, options, -1, &difference.image);
+        return difference;
+    }));
+}
+
+bool ImageCompareWidget::savedMetricsApply() const
+{
+    // Saved counts are only meaningful for the tolerance they were made with
+    return savedMetrics.isValid()
+        && std::abs(savedMetrics.perceptualThreshold - differenceOptions.threshold) < THRESHOLD_EPSILON
+        && savedMetrics.includeAntiAliasing == differenceOptions.includeAntiAliasing;
+}
+
 void ImageCompareWidget::setDissolveSettings(double newHoldTime, double newTransitionTime)
 {
     holdTime = qMax(0.1, newHoldTime); // Minimum 0.1 seconds
@@ -452,8 +1403,9 @@ void ImageCompareWidget::stopDissolve()
 
 void ImageCompareWidget::setOpacity(double opacity)
 {
+    // The animation runs on its own clock; frames show its latest value
     currentOpacity = qBound(0.0, opacity, 1.0);
-    update();
+    frameScheduler->requestFrame();
 }
 
 void ImageCompareWidget::onDissolveTimer()
@@ -8,7 +8,7 @@
 #define IMAGECOMPAREWIDGET_H
 
 #include <QWidget>
-#include <QPixmap>
+#include <QImage>
 #include <QPainter>
 #include <QMouseEvent>
 #include <QWheelEvent>
@@ -17,6 +17,14 @@
 #include <QPoint>
 #include <QTimer>
 #include <QPropertyAnimation>
+#include <QElapsedTimer>
+#include <QVector>
+#include "diffmap.h"
+#include "diffsidecar.h"
+#include "perceptualdiff.h"
+#include "framescheduler.h"
+#include "viewrenderer.h"
+#include "imagestats.h"
 
 class ImageCompareWidget : public QWidget
 {
@@ -32,22 +40,59 @@ public:
 
     enum CompareMode {
         WipeMode,
-        DissolveMode
+        DissolveMode,
+        DifferenceMode,
+        FlipMode       // Space shows the other image: tap to toggle, hold to peek
     };
 
     explicit ImageCompareWidget(QWidget *parent = nullptr);
     
     void setImages(const QString &firstImagePath, const QString &secondImagePath);
+    void setImage(int side, const QImage &image); // 0 = first, 1 = second; keeps the view
+    // Both frames of a playing sequence; analyze also rebuilds the change map,
+    // which playback skips to hold its frame rate
+    void setFrames(const QImage &first, const QImage &second, bool analyze);
     void setDirection(CompareDirection direction);
     void setCompareMode(CompareMode mode);
     void setDissolveSettings(double holdTime, double transitionTime);
     void startDissolve();
     void stopDissolve();
+    void setZoomFactor(double factor);
+    void setDifferenceSettings(const PerceptualDiff::Options &options);
+    
+    // Load timings are reported relative to this as well, for cold starts
+    void setLaunchTimer(const QElapsedTimer &timer);
+    
+    // Loupe showing source pixels under the cursor
+    void setLoupeEnabled(bool enabled);
+    void setLoupeMagnification(int magnification);
+    
+    // Change map navigation
+    void setChangeOverlayVisible(bool visible);
+    void nextChangedRegion();
+    void previousChangedRegion();
+    
+    // Memory held by each source image in its stored format
+    qint64 imageBytes(int side) const;
+    QImage::Format imageFormat(int side) const;
+    
+    // Statistics from the full-resolution load, invalid until it finishes;
+    // I toggles the info panel showing them
+    ImageStats imageStats(int side) const;
+    void setInfoPanelVisible(bool visible);
+    
+    // Input-to-paint latency; F toggles the on-screen readout
+    FrameScheduler::Stats frameStats() const;
+    void setFrameStatsVisible(bool visible);
     
     QSize sizeHint() const override;
 
 public slots:
     void setOpacity(double opacity);
+    void setFlipped(bool flipped); // flip mode: true shows the second image
+
+signals:
+    void imagesChanged();
 
 protected:
     void paintEvent(QPaintEvent *event) override;
@@ -56,10 +101,12 @@ protected:
     void mouseReleaseEvent(QMouseEvent *event) override;
     void wheelEvent(QWheelEvent *event) override;
     void keyPressEvent(QKeyEvent *event) override;
+    void keyReleaseEvent(QKeyEvent *event) override;
     void leaveEvent(QEvent *event) override;
 
 private slots:
     void onDissolveTimer();
+    void applyPendingInput();
 
 private:
     void updateRevealPosition(const QPoint &mousePos);
@@ -69,13 +116,68 @@ private:
     void updateImageTransforms();
     void startDissolveTransition();
     QPoint mapToImageCoordinates(const QPoint &widgetPos) const;
-    QPixmap scalePixmapToFit(const QPixmap &pixmap, const QSize &targetSize) const;
-    QPixmap scalePixmapToFill(const QPixmap &pixmap, const QSize &targetSize) const;
+    void startFullLoad(int side, const QString &path, bool cacheAfterLoad);
+    void startSidecarRead(const QString &firstPath, const QString &secondPath);
+    void startStats();
+    void setSideImage(int side, const QImage &image, bool fullResolution);
+    QImage loadPreview(const QString &path, bool *fromCache) const;
+    void reportLoadTiming(const QString &stage);
+    void drawInfoPanel(QPainter &painter);
+    void renderLoupe(const QRect &imageRect);
+    void drawLoupe(QPainter &painter, const QRect &imageRect);
+    void requestChangeMap();
+    void cancelChangeMap();
+    void startChangeMap();
+    void invalidateDifference();
+    void updateDifferenceImage();
+    bool savedMetricsApply() const;
+    double fitScale() const;
+    void focusChangedRegion(int index);
+    QRect displayRect(const QImage &image) const;
+    ViewRenderer::ViewState viewState() const;
+    QRect revealRect(const QRect &secondRect) const;
+    QImage scaleImageToFill(const QImage &image, const QSize &targetSize) const;
+
+    struct LoadedImage {
+        QImage image;
+        ImageStats stats;
+    };
+
+    struct PairStats {
+        ImageStats first;
+        ImageStats second;
+    };
 
-    QPixmap firstImage;
-    QPixmap secondImage;
-    QPixmap scaledFirstImage;
-    QPixmap scaledSecondImage;
+    struct SavedAnalysis {
+        bool found;
+        DiffMap map;
+        DiffSidecar::Metrics metrics;
+    };
+
+    struct Difference {
+        QImage image;
+        PerceptualDiff::Result result;
+    };
+
+    QImage firstImage;  // stored compact (Grayscale8, RGB888, ...), not in display format
+    QImage secondImage;
+    ImageStats firstStats;   // gathered while each full decode was still in cache
+    ImageStats secondStats;
+    bool showInfoPanel;
+    bool statsRunning;       // one pass in flight for images that arrived without stats
+    ViewRenderer *renderer;   // composes the image layers off the GUI thread
+    bool firstIsFullResolution;  // false while a cached pyramid level stands in
+    bool secondIsFullResolution;
+    int loadGeneration; // bumped whenever either image is replaced
+    int firstDecodeGeneration;  // bumped when that side is replaced, so only its stale decode is dropped
+    int secondDecodeGeneration;
+    
+    // Load timing
+    QElapsedTimer loadTimer;   // started by setImages
+    QElapsedTimer launchTimer; // process start, valid until the first pair is fully loaded
+    bool firstPixelsReported;
+    bool fullResolutionReported;
+    QString previewSource;
     
     CompareDirection direction;
     CompareMode compareMode;
@@ -88,6 +190,14 @@ private:
     QPoint lastPanPoint;
     bool isPanning;
     
+    // Input coalesced until the next frame; handlers only record it
+    FrameScheduler *frameScheduler;
+    QPoint pendingMousePos;
+    bool mouseMovePending;
+    int pendingZoomSteps;    // net wheel notches, positive zooms in
+    QPoint pendingZoomCenter;
+    bool showFrameStats;
+    
     // Dissolve functionality
     QTimer *dissolveTimer;
     QPropertyAnimation *opacityAnimation;
@@ -97,11 +207,51 @@ private:
     bool isDissolving;
     bool showingSecondImage; // true when transitioning to/showing second image
     
+    // Flip functionality; both images are kept composed for the current view,
+    // so flipping only changes which finished frame is blitted
+    bool flipped;
+    QElapsedTimer flipPressTimer; // a press held longer than FLIP_HOLD_MS flips back on release
+    
+    // Loupe functionality
+    bool loupeEnabled;
+    QPoint loupeCursor;      // widget position the loupe follows, (-1, -1) when hidden
+    int loupeMagnification;  // screen pixels per source pixel
+    QImage loupeBuffer;      // LOUPE_SIZE square, filled in place on every move
+    QVector<int> loupeFirstColumns;  // source x per loupe column, -1 outside the image
+    QVector<int> loupeSecondColumns;
+    QVector<uchar> loupeColumnSide;  // 1 where the wipe reveals the second image
+    
+    // Change map functionality
+    DiffMap changeMap;
+    QImage changeOverlay; // one pixel per block, stretched over the image
+    bool showChangeOverlay;
+    int currentRegion; // index into changeMap.regions(), -1 when none focused
+    int changeMapGeneration; // bumped whenever the images the map is built from change
+    bool changeMapWanted;    // a map for the current images is needed
+    bool changeMapRunning;   // one build in flight at a time
+    bool changeMapSaved;     // changeMap came from the pair's verified sidecar, so it is not rebuilt
+    DiffSidecar::Metrics savedMetrics;
+    
+    // Difference mode functionality
+    PerceptualDiff::Options differenceOptions;
+    PerceptualDiff::Result differenceResult;
+    QImage differenceImage; // size of the first image it was made from, null until needed
+    int differenceGeneration;      // bumped whenever the images or options change
+    int differenceImageGeneration; // generation differenceImage was computed for
+    bool differenceRunning;        // one compare in flight at a time
+    
     static const int DEFAULT_WIDTH = 800;
     static const int DEFAULT_HEIGHT = 600;
     static constexpr double MIN_ZOOM = 0.1;
     static constexpr double MAX_ZOOM = 10.0;
     static constexpr double ZOOM_STEP = 1.2;
+    static const int INFO_PANEL_WIDTH = 280;
+    static const int FLIP_HOLD_MS = 250;
+    static const int LOUPE_SIZE = 192;
+    static const int LOUPE_OFFSET = 24; // gap between cursor and loupe
+    static const int MAX_LOUPE_MAGNIFICATION = 16;
+    static constexpr double REGION_VIEW_FRACTION = 0.4; // share of the view a focused region fills
+    static constexpr double THRESHOLD_EPSILON = 1e-6; // absolute, so a saved 0 tolerance matches 0
 };
 
 #endif // IMAGECOMPAREWIDGET_H
@@ -0,0 +1,310 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#include "imageloader.h"
+#include "resampler.h"
+#include <QBuffer>
+#include <QFile>
+#include <QImageReader>
+#include <QTransform>
+#include <QVector>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const int MAX_IFD_ENTRIES = 1000;
+const int MAX_IFD_DEPTH = 4;
+const qint64 JPEG_HEADER_BYTES = 128 * 1024; // room for SOI plus a full APP1 segment
+
+struct PreviewRange {
+    quint32 offset;
+    quint32 length;
+};
+
+// Just enough of a TIFF reader to find embedded JPEG previews. Works on the
+// TIFF block inside a JPEG's Exif APP1 segment as well as on TIFF-based raw
+// files (DNG, CR2, NEF, ARW, ...), where offsets are relative to the block.
+class TiffReader
+{
+public:
+    TiffReader(const uchar *data, qint64 size)
+        : data(data)
+        , size(size)
+        , bigEndian(false)
+        , valid(false)
+    {
+        if (size < 8) return;
+        if (data[0] == 'I' && data[1] == 'I') {
+            bigEndian = false;
+        } else if (data[0] == 'M' && data[1] == 'M') {
+            bigEndian = true;
+        } else {
+            return;
+        }
+        valid = (read16(2) == 42);
+    }
+
+    bool isValid() const { return valid; }
+
+    quint16 read16(qint64 offset) const
+    {
+        if (offset < 0 || offset + 2 > size) return 0;
+        return bigEndian ? static_cast<quint16>((data[offset] << 8) | data[offset + 1])
+                         : static_cast<quint16>(data[offset] | (data[offset + 1] << 8));
+    }
+
+    quint32 read32(qint64 offset) const
+    {
+        if (offset < 0 || offset + 4 > size) return 0;
+        if (bigEndian) {
+            return (quint32(data[offset]) << 24) | (quint32(data[offset + 1]) << 16)
+                 | (quint32(data[offset + 2]) << 8) | quint32(data[offset + 3]);
+        }
+        return quint32(data[offset]) | (quint32(data[offset + 1]) << 8)
+             | (quint32(data[offset + 2]) << 16) | (quint32(data[offset + 3]) << 24);
+    }
+
+    // Walk an IFD chain (and any SubIFDs) collecting JPEG previews. The
+    // orientation is taken from the first IFD, which describes the main image.
+    void collectPreviews(quint32 ifdOffset, int depth, QVector<PreviewRange> *previews, int *orientation) const
+    {
+        int chainLength = 0;
+        while (ifdOffset != 0 && depth <= MAX_IFD_DEPTH && chainLength++ < MAX_IFD_DEPTH * 2) {
+            const int entryCount = read16(ifdOffset);
+            if (entryCount == 0 || entryCount > MAX_IFD_ENTRIES) return;
+
+            quint32 jpegOffset = 0;
+            quint32 jpegLength = 0;
+            quint32 compression = 0;
+            quint32 stripOffset = 0;
+            quint32 stripLength = 0;
+
+            for (int i = 0; i < entryCount; ++i) {
+                const qint64 entry = ifdOffset + 2 + i * 12;
+                const quint16 tag = read16(entry);
+                const quint16 type = read16(entry + 2);
+                const quint32 count = read32(entry + 4);
+                // SHORT values sit in the first half of the value field
+                const quint32 value = (type == 3) ? read16(entry + 8) : read32(entry + 8);
+
+                switch (tag) {
+                    case 0x0103: compression = value; break;
+                    case 0x0111: if (count == 1) stripOffset = value; break;
+                    case 0x0117: if (count == 1) stripLength = value; break;
+                    case 0x0112:
+                        if (depth == 0 && chainLength == 1) *orientation = static_cast<int>(value);
+                        break;
+                    case 0x0201: jpegOffset = value; break;
+                    case 0x0202: jpegLength = value; break;
+                    case 0x014A: // SubIFDs: inline when single, otherwise an offset array
+                        for (quint32 sub = 0; sub < qMin<quint32>(count, 8); ++sub) {
+                            quint32 subOffset = (count == 1) ? value : read32(value + sub * 4);
+                            collectPreviews(subOffset, depth + 1, previews, orientation);
+                        }
+                        break;
+                    default:
+                        break;
+                }
+            }
+
+            if (jpegOffset != 0 && jpegLength != 0) {
+                previews->append({jpegOffset, jpegLength});
+            } else if ((compression == 6 || compression == 7) && stripOffset != 0 && stripLength != 0) {
+                // Old-style or lossless JPEG strips; the decoder rejects what it cannot read
+                previews->append({stripOffset, stripLength});
+            }
+
+            ifdOffset = read32(ifdOffset + 2 + entryCount * 12);
+        }
+    }
+
+    QImage decodeLargestPreview(int maxDimension, int *orientation) const
+    {
+        QVector<PreviewRange> previews;
+        collectPreviews(read32(4), 0, &previews, orientation);
+
+        std::sort(previews.begin(), previews.end(), [](const PreviewRange &a, const PreviewRange &b) {
+            return a.length > b.length;
+        });
+
+        for (const PreviewRange &preview : previews) {
+            if (static_cast<qint64>(preview.offset) + preview.length > size) continue;
+
+            QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(data + preview.offset),
+                                                       static_cast<int>(preview.length));
+            QBuffer buffer(&bytes);
+            buffer.open(QIODevice::ReadOnly);
+            QImageReader reader(&buffer, "jpeg");
+            QSize previewSize = reader.size();
+            if (previewSize.isValid() && (previewSize.width() > maxDimension || previewSize.height() > maxDimension)) {
+                reader.setScaledSize(previewSize.scaled(maxDimension, maxDimension, Qt::KeepAspectRatio));
+            }
+            // Detach from the borrowed bytes before they go away
+            QImage image = reader.read();
+            if (!image.isNull()) return image.copy();
+        }
+        return QImage();
+    }
+
+private:
+    const uchar *data;
+    qint64 size;
+    bool bigEndian;
+    bool valid;
+};
+
+// Apply an EXIF orientation tag, which embedded previews do not carry themselves
+QImage applyOrientation(const QImage &image, int orientation)
+{
+    switch (orientation) {
+        case 2: return image.mirrored(true, false);
+        case 3: return image.transformed(QTransform().rotate(180));
+        case 4: return image.mirrored(false, true);
+        case 5: return image.mirrored(true, false).transformed(QTransform().rotate(270));
+        case 6: return image.transformed(QTransform().rotate(90));
+        case 7: return image.mirrored(true, false).transformed(QTransform().rotate(90));
+        case 8: return image.transformed(QTransform().rotate(270));
+        default: return image;
+    }
+}
+
+// Locate the TIFF block of the Exif APP1 segment, scanning markers up to the image data
+QImage previewFromJpeg(const QByteArray &header, int maxDimension)
+{
+    const uchar *data = reinterpret_cast<const uchar *>(header.constData());
+    const qint64 size = header.size();
+
+    qint64 pos = 2;
+    while (pos + 4 <= size) {
+        if (data[pos] != 0xFF) return QImage();
+        const uchar marker = data[pos + 1];
+        if (marker == 0xFF) { // fill byte
+            ++pos;
+            continue;
+        }
+        if (marker == 0xDA || marker == 0xD9) return QImage(); // image data reached, no Exif
+
+        const qint64 length = (data[pos + 2] << 8) | data[pos + 3];
+        if (marker == 0xE1 && length >= 16 && pos + 2 + length <= size
+            && std::memcmp(data + pos + 4, "Exif\0\0", 6) == 0) {
+            TiffReader tiff(data + pos + 10, length - 8);
+            if (!tiff.isValid()) return QImage();
+            int orientation = 1;
+            QImage preview = tiff.decodeLargestPreview(maxDimension, &orientation);
+            return applyOrientation(preview, orientation);
+        }
+        pos += 2 + length;
+    }
+    return QImage();
+}
+
+} // namespace
+
+QImage ImageLoader::loadEmbeddedPreview(const QString &path, int maxDimension)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return QImage();
+
+    // JPEG: the Exif thumbnail lives in the first few kilobytes
+    QByteArray header = file.read(JPEG_HEADER_BYTES);
+    if (header.size() >= 4 && static_cast<uchar>(header.at(0)) == 0xFF && static_cast<uchar>(header.at(1)) == 0xD8) {
+        return previewFromJpeg(header, maxDimension);
+    }
+
+    // TIFF-based raw: previews can sit anywhere, so map the whole file
+    TiffReader probe(reinterpret_cast<const uchar *>(header.constData()), header.size());
+    if (!probe.isValid()) return QImage();
+
+    uchar *data = file.map(0, file.size());
+    if (!data) return QImage();
+
+    TiffReader tiff(data, file.size());
+    int orientation = 1;
+    QImage preview = tiff.decodeLargestPreview(maxDimension, &orientation);
+    return applyOrientation(preview, orientation);
+}
+
+QImage ImageLoader::load(const QString &path)
+{
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+    return reader.read();
+}
+
+QImage ImageLoader::compact(const QImage &image)
+{
+    const QImage::Format format = image.format();
+    if (format != QImage::Format_RGB32 && format != QImage::Format_ARGB32
+        && format != QImage::Format_ARGB32_Premultiplied) {
+        return image;
+    }
+
+    // One pass decides both questions; colour without alpha stops at the
+    // first non-grey pixel
+    const bool hasAlpha = (format != QImage::Format_RGB32);
+    bool gray = true;
+    for (int y = 0; y < image.height(); ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            const QRgb pixel = line[x];
+            if (hasAlpha && qAlpha(pixel) != 255) return image;
+            gray = gray && qRed(pixel) == qGreen(pixel) && qGreen(pixel) == qBlue(pixel);
+        }
+        if (!gray && !hasAlpha) break;
+    }
+
+    return image.convertToFormat(gray ? QImage::Format_Grayscale8 : QImage::Format_RGB888);
+}
+
+QImage ImageLoader::compact(const QImage &image, const ImageStats &stats)
+{
+    const QImage::Format format = image.format();
+    if (!stats.isValid() || (format != QImage::Format_RGB32 && format != QImage::Format_ARGB32
+                             && format != QImage::Format_ARGB32_Premultiplied)) {
+        return compact(image);
+    }
+    if (format != QImage::Format_RGB32 && !stats.opaque) return image;
+    return image.convertToFormat(stats.grayscale ? QImage::Format_Grayscale8 : QImage::Format_RGB888);
+}
+
+QImage ImageLoader::loadWithStats(const QString &path, ImageStats *stats)
+{
+    const QImage image = load(path);
+    *stats = ImageStats::compute(image);
+    return compact(image, *stats);
+}
+
+QImage ImageLoader::loadReduced(const QString &path, int maxDimension)
+{
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+
+    QSize fullSize = reader.size();
+    if (fullSize.isValid() && maxDimension > 0
+        && (fullSize.width() > maxDimension || fullSize.height() > maxDimension)) {
+        reader.setScaledSize(fullSize.scaled(maxDimension, maxDimension, Qt::KeepAspectRatio));
+    }
+
+    QImage image = reader.read();
+    if (image.isNull()) {
+        // Formats Qt cannot decode (camera raws) may still carry a usable preview
+        image = loadEmbeddedPreview(path, maxDimension);
+        if (image.isNull()) return QImage();
+    }
+
+    // Handlers without scaled decoding ignore the request; scale afterwards
+    if (maxDimension > 0 && (image.width() > maxDimension || image.height() > maxDimension)) {
+        image = Resampler::scale(image, image.size().scaled(maxDimension, maxDimension, Qt::KeepAspectRatio));
+    }
+    return image;
+}
+
+QStringList ImageLoader::imageNameFilters()
+{
+    return QStringList() << "*.png" << "*.jpg" << "*.jpeg" << "*.bmp" << "*.gif" << "*.tiff" << "*.tif"
+                         << "*.dng" << "*.cr2" << "*.nef" << "*.arw";
+}
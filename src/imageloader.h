@@ -0,0 +1,52 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#ifndef IMAGELOADER_H
+#define IMAGELOADER_H
+
+#include <QImage>
+#include <QString>
+#include <QStringList>
+#include "imagestats.h"
+
+class ImageLoader
+{
+public:
+    // Full-resolution decode with EXIF orientation applied. Safe to call
+    // from worker threads.
+    static QImage load(const QString &path);
+
+    // Decode an image no larger than maxDimension on its longest side. Formats
+    // that support it (JPEG) downscale while decoding, which is much cheaper
+    // than a full decode followed by a resize.
+    static QImage loadReduced(const QString &path, int maxDimension);
+
+    // Embedded preview from the file's EXIF/TIFF structure (JPEG thumbnail,
+    // raw preview), oriented like the main image. Cheap enough to call on the
+    // GUI thread; returns a null image when the file carries none.
+    static QImage loadEmbeddedPreview(const QString &path, int maxDimension = PREVIEW_MAX_DIMENSION);
+
+    // Smallest lossless storage for a decoded image: 32-bit RGB drops its
+    // padding byte, images whose pixels are all grey become Grayscale8, and
+    // fully opaque alpha images drop the alpha channel. Other formats are
+    // already compact and are returned unchanged.
+    static QImage compact(const QImage &image);
+
+    // As above, deciding from statistics already gathered for the image
+    // instead of scanning it again
+    static QImage compact(const QImage &image, const ImageStats &stats);
+
+    // Full decode, one fused statistics pass while the pixels are still in
+    // cache, then compact storage. Safe to call from worker threads.
+    static QImage loadWithStats(const QString &path, ImageStats *stats);
+
+    // Name filters for the formats the file dialogs and folder scans accept
+    static QStringList imageNameFilters();
+
+    static const int PREVIEW_MAX_DIMENSION = 2048;
+};
+
+#endif // IMAGELOADER_H
@@ -0,0 +1,182 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#include "imagematcher.h"
+#include "imageloader.h"
+#include "perceptualhash.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QVector>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+
+namespace {
+
+struct HashedFile {
+    QString path;
+    quint64 hash;
+    bool valid;
+};
+
+struct Candidate {
+    int first;  // index into the first folder's files
+    int second; // index into the second folder's files
+    int distance;
+};
+
+// Burkhard-Keller tree over Hamming distance. A radius query only descends
+// into children whose edge distance lies within [d - r, d + r], so lookups
+// touch a small fraction of the tree for the tight radii used for matching.
+class BKTree
+{
+public:
+    void insert(quint64 hash, int index)
+    {
+        Node node;
+        node.hash = hash;
+        node.index = index;
+        std::fill(std::begin(node.children), std::end(node.children), -1);
+
+        if (nodes.isEmpty()) {
+            nodes.append(node);
+            return;
+        }
+
+        int current = 0;
+        for (;;) {
+            int d = PerceptualHash::distance(hash, nodes.at(current).hash);
+            int child = nodes.at(current).children[d];
+            if (child < 0) {
+                nodes[current].children[d] = nodes.size();
+                nodes.append(node);
+                return;
+            }
+            current = child;
+        }
+    }
+
+    void query(quint64 hash, int radius, QVector<QPair<int, int>> *results) const
+    {
+        if (nodes.isEmpty()) return;
+
+        QVector<int> stack;
+        stack.append(0);
+        while (!stack.isEmpty()) {
+            const Node &node = nodes.at(stack.takeLast());
+            int d = PerceptualHash::distance(hash, node.hash);
+            if (d <= radius) {
+                results->append(qMakePair(node.index, d));
+            }
+            int low = qMax(0, d - radius);
+            int high = qMin(64, d + radius);
+            for (int edge = low; edge <= high; ++edge) {
+                if (node.children[edge] >= 0) {
+                    stack.append(node.children[edge]);
+                }
+            }
+        }
+    }
+
+private:
+    struct Node {
+        quint64 hash;
+        int index;
+        int children[65]; // indexed by distance to this node, -1 when empty
+    };
+
+    QVector<Node> nodes;
+};
+
+QVector<HashedFile> hashFiles(const QStringList &paths, PerceptualHashCache &cache)
+{
+    QVector<HashedFile> files(paths.size());
+    QVector<int> missing;
+
+    for (int i = 0; i < paths.size(); ++i) {
+        files[i].path = paths.at(i);
+        files[i].valid = cache.lookup(paths.at(i), &files[i].hash);
+        if (!files[i].valid) {
+            missing.append(i);
+        }
+    }
+
+    // Decode and hash uncached files across the thread pool
+    QtConcurrent::blockingMap(missing, [&files](int index) {
+        HashedFile &file = files[index];
+        file.valid = PerceptualHash::computeFile(file.path, &file.hash);
+    });
+
+    for (int index : missing) {
+        if (files.at(index).valid) {
+            cache.insert(files.at(index).path, files.at(index).hash);
+        }
+    }
+    return files;
+}
+
+} // namespace
+
+QStringList ImageMatcher::imageFiles(const QString &dir)
+{
+    QDir directory(dir);
+    QStringList paths;
+    const QFileInfoList entries = directory.entryInfoList(ImageLoader::imageNameFilters(),
+                                                          QDir::Files | QDir::Readable, QDir::Name);
+    for (const QFileInfo &entry : entries) {
+        paths.append(entry.absoluteFilePath());
+    }
+    return paths;
+}
+
+QList<ImagePair> ImageMatcher::matchFolders(const QString &firstDir, const QString &secondDir, int maxDistance)
+{
+    PerceptualHashCache cache;
+    cache.load();
+
+    const QVector<HashedFile> firstFiles = hashFiles(imageFiles(firstDir), cache);
+    const QVector<HashedFile> secondFiles = hashFiles(imageFiles(secondDir), cache);
+    cache.save();
+
+    BKTree tree;
+    for (int i = 0; i < secondFiles.size(); ++i) {
+        if (secondFiles.at(i).valid) {
+            tree.insert(secondFiles.at(i).hash, i);
+        }
+    }
+
+    // Gather every candidate within range, then assign greedily by distance
+    // so each image is used at most once and the closest matches win
+    QVector<Candidate> candidates;
+    QVector<QPair<int, int>> hits;
+    for (int i = 0; i < firstFiles.size(); ++i) {
+        if (!firstFiles.at(i).valid) continue;
+        hits.clear();
+        tree.query(firstFiles.at(i).hash, maxDistance, &hits);
+        for (const QPair<int, int> &hit : hits) {
+            candidates.append({i, hit.first, hit.second});
+        }
+    }
+
+    std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+        return a.distance < b.distance;
+    });
+
+    QVector<bool> firstUsed(firstFiles.size(), false);
+    QVector<bool> secondUsed(secondFiles.size(), false);
+    QList<ImagePair> pairs;
+    for (const Candidate &candidate : candidates) {
+        if (firstUsed.at(candidate.first) || secondUsed.at(candidate.second)) continue;
+        firstUsed[candidate.first] = true;
+        secondUsed[candidate.second] = true;
+        pairs.append({firstFiles.at(candidate.first).path, secondFiles.at(candidate.second).path, candidate.distance});
+    }
+
+    // Present pairs in the first folder's order
+    std::sort(pairs.begin(), pairs.end(), [](const ImagePair &a, const ImagePair &b) {
+        return a.firstPath < b.firstPath;
+    });
+    return pairs;
+}
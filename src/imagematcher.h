@@ -0,0 +1,31 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#ifndef IMAGEMATCHER_H
+#define IMAGEMATCHER_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+struct ImagePair {
+    QString firstPath;
+    QString secondPath;
+    int distance; // Hamming distance between the perceptual hashes
+};
+
+// Pairs images across two folders by content rather than file name
+class ImageMatcher
+{
+public:
+    static QList<ImagePair> matchFolders(const QString &firstDir, const QString &secondDir,
+                                         int maxDistance = DEFAULT_MAX_DISTANCE);
+    static QStringList imageFiles(const QString &dir);
+
+    static const int DEFAULT_MAX_DISTANCE = 10; // of 64 bits
+};
+
+#endif // IMAGEMATCHER_H
@@ -0,0 +1,104 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#include "imagesequence.h"
+#include "imageloader.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QMap>
+#include <QRegularExpression>
+
+ImageSequence::ImageSequence()
+    : containerFrames(0)
+    , startFrame(0)
+{
+}
+
+ImageSequence ImageSequence::open(const QString &path, bool expandNumbered)
+{
+    ImageSequence sequence;
+    QFileInfo info(path);
+    if (!info.isFile()) return sequence;
+
+    // Numbered frames: same prefix and suffix, any run of digits in between
+    static const QRegularExpression numbered("^(.*?)(\\d+)(\\D*)$");
+    QRegularExpressionMatch match = numbered.match(info.fileName());
+    if (expandNumbered && match.hasMatch()) {
+        const QString prefix = match.captured(1);
+        const QString suffix = match.captured(3);
+        const QRegularExpression sibling("^" + QRegularExpression::escape(prefix) + "(\\d+)"
+                                         + QRegularExpression::escape(suffix) + "$");
+
+        QMap<qint64, QString> frames;
+        const QDir dir = info.absoluteDir();
+        const QStringList entries = dir.entryList(QStringList() << prefix + "*" + suffix, QDir::Files);
+        for (const QString &entry : entries) {
+            QRegularExpressionMatch frame = sibling.match(entry);
+            if (frame.hasMatch()) {
+                frames.insert(frame.captured(1).toLongLong(), dir.filePath(entry));
+            }
+        }
+
+        if (frames.size() > 1) {
+            sequence.files = frames.values();
+            sequence.startFrame = qMax(0, static_cast<int>(sequence.files.indexOf(info.absoluteFilePath())));
+            return sequence;
+        }
+    }
+
+    // Multi-frame containers are always played as sequences
+    QImageReader reader(path);
+    sequence.containerPath = path;
+    sequence.containerFrames = qMax(1, reader.imageCount());
+    return sequence;
+}
+
+bool ImageSequence::isNull() const
+{
+    return files.isEmpty() && containerPath.isEmpty();
+}
+
+int ImageSequence::frameCount() const
+{
+    return files.isEmpty() ? containerFrames : static_cast<int>(files.size());
+}
+
+int ImageSequence::initialFrame() const
+{
+    return startFrame;
+}
+
+ImageSequence::Reader::Reader(const ImageSequence &sequence)
+    : files(sequence.files)
+    , containerPath(sequence.containerPath)
+    , nextContainerFrame(0)
+{
+}
+
+QImage ImageSequence::Reader::read(int frame)
+{
+    if (!files.isEmpty()) {
+        return ImageLoader::load(files.value(frame));
+    }
+    if (containerPath.isEmpty()) return QImage();
+
+    // Going backwards means starting over, unless the format can seek
+    if (!container || frame < nextContainerFrame) {
+        container.reset(new QImageReader(containerPath));
+        container->setAutoTransform(true);
+        nextContainerFrame = 0;
+    }
+    if (frame != nextContainerFrame && container->jumpToImage(frame)) {
+        nextContainerFrame = frame;
+    }
+    while (nextContainerFrame < frame) {
+        if (container->read().isNull()) return QImage();
+        ++nextContainerFrame;
+    }
+
+    ++nextContainerFrame;
+    return container->read();
+}
@@ -0,0 +1,56 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#ifndef IMAGESEQUENCE_H
+#define IMAGESEQUENCE_H
+
+#include <QImage>
+#include <QImageReader>
+#include <QScopedPointer>
+#include <QString>
+#include <QStringList>
+
+// An ordered list of frames behind one image path: the numbered siblings of
+// a file such as frame_0001.png, or the frames of a multi-frame GIF or
+// multi-page TIFF. A plain still is a sequence of one frame.
+class ImageSequence
+{
+public:
+    ImageSequence();
+
+    // expandNumbered: treat a file name ending in digits as one frame of a
+    // numbered sequence and collect its siblings
+    static ImageSequence open(const QString &path, bool expandNumbered);
+
+    bool isNull() const;
+    int frameCount() const;
+    int initialFrame() const; // frame of the path the sequence was opened from
+
+    // Decodes frames for one worker thread. Multi-frame files are read
+    // forwards with one open reader, so sequential playback never rescans
+    // the file from the start.
+    class Reader
+    {
+    public:
+        explicit Reader(const ImageSequence &sequence);
+
+        QImage read(int frame);
+
+    private:
+        QStringList files;
+        QString containerPath;
+        QScopedPointer<QImageReader> container;
+        int nextContainerFrame;
+    };
+
+private:
+    QStringList files;       // one file per frame for numbered sequences
+    QString containerPath;   // multi-frame file, used when files is empty
+    int containerFrames;
+    int startFrame;
+};
+
+#endif // IMAGESEQUENCE_H
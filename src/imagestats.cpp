@@ -0,0 +1,196 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#include "imagestats.h"
+#include <QVector>
+#include <QtConcurrent/QtConcurrentMap>
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+const quint64 PRIME_1 = Q_UINT64_C(0x9E3779B185EBCA87);
+const quint64 PRIME_2 = Q_UINT64_C(0xC2B2AE3D27D4EB4F);
+const quint64 PRIME_3 = Q_UINT64_C(0x165667B19E3779F9);
+const int LANES = 4;
+
+inline quint64 rotateLeft(quint64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline quint64 mixLane(quint64 lane, quint32 value)
+{
+    return rotateLeft(lane + value * PRIME_2, 31) * PRIME_1;
+}
+
+inline quint64 avalanche(quint64 hash)
+{
+    hash ^= hash >> 33;
+    hash *= PRIME_2;
+    hash ^= hash >> 29;
+    hash *= PRIME_3;
+    return hash ^ (hash >> 32);
+}
+
+struct Band {
+    quint32 histogram[ImageStats::ChannelCount][256];
+    quint64 lanes[LANES];
+    bool grayscale;
+    bool opaque;
+    bool lumaOnly; // greyscale source: R, G and B histograms equal the luma one
+};
+
+inline int luma(int red, int green, int blue)
+{
+    return (77 * red + 150 * green + 29 * blue) >> 8;
+}
+
+// One visit per pixel: histograms, flags and hash lanes together. Hash lanes
+// follow the column, so each lane is an independent multiply chain.
+template <typename Fetch>
+void scanRow(int width, Fetch fetch, Band &band)
+{
+    for (int x = 0; x < width; ++x) {
+        const QRgb pixel = fetch(x);
+        const int red = qRed(pixel);
+        const int green = qGreen(pixel);
+        const int blue = qBlue(pixel);
+        band.histogram[ImageStats::Red][red]++;
+        band.histogram[ImageStats::Green][green]++;
+        band.histogram[ImageStats::Blue][blue]++;
+        band.histogram[ImageStats::Luma][luma(red, green, blue)]++;
+        band.grayscale &= (red == green) & (green == blue);
+        band.opaque &= qAlpha(pixel) == 255;
+        band.lanes[x & (LANES - 1)] = mixLane(band.lanes[x & (LANES - 1)], pixel);
+    }
+}
+
+void scanBand(const QImage &image, int top, int bottom, Band &band)
+{
+    std::memset(band.histogram, 0, sizeof(band.histogram));
+    for (int lane = 0; lane < LANES; ++lane) {
+        band.lanes[lane] = PRIME_1 + lane * PRIME_2;
+    }
+    band.grayscale = true;
+    band.opaque = true;
+    band.lumaOnly = false;
+
+    const int width = image.width();
+    switch (image.format()) {
+    case QImage::Format_Grayscale8:
+        band.lumaOnly = true;
+        for (int y = top; y < bottom; ++y) {
+            const uchar *line = image.constScanLine(y);
+            for (int x = 0; x < width; ++x) {
+                band.histogram[ImageStats::Luma][line[x]]++;
+                band.lanes[x & (LANES - 1)] = mixLane(band.lanes[x & (LANES - 1)],
+                                                      0xff000000u | (line[x] * 0x010101u));
+            }
+        }
+        break;
+    case QImage::Format_RGB888:
+        for (int y = top; y < bottom; ++y) {
+            const uchar *line = image.constScanLine(y);
+            scanRow(width, [line](int x) {
+                return qRgb(line[x * 3], line[x * 3 + 1], line[x * 3 + 2]);
+            }, band);
+        }
+        break;
+    case QImage::Format_RGB32:
+        for (int y = top; y < bottom; ++y) {
+            const QRgb *line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+            scanRow(width, [line](int x) { return line[x] | 0xff000000u; }, band);
+        }
+        break;
+    case QImage::Format_ARGB32:
+        for (int y = top; y < bottom; ++y) {
+            const QRgb *line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+            scanRow(width, [line](int x) { return line[x]; }, band);
+        }
+        break;
+    default: {
+        // Other formats are converted a band at a time, while it is in cache
+        const QImage rows = image.copy(0, top, width, bottom - top).convertToFormat(QImage::Format_ARGB32);
+        for (int y = 0; y < rows.height(); ++y) {
+            const QRgb *line = reinterpret_cast<const QRgb *>(rows.constScanLine(y));
+            scanRow(width, [line](int x) { return line[x]; }, band);
+        }
+        break;
+    }
+    }
+}
+
+} // namespace
+
+ImageStats::ImageStats()
+    : pixelCount(0)
+    , contentHash(0)
+    , grayscale(false)
+    , opaque(false)
+{
+    std::memset(histogram, 0, sizeof(histogram));
+    for (int channel = 0; channel < ChannelCount; ++channel) {
+        minimum[channel] = 0;
+        maximum[channel] = 0;
+        mean[channel] = 0.0;
+    }
+}
+
+ImageStats ImageStats::compute(const QImage &image)
+{
+    ImageStats stats;
+    if (image.isNull()) return stats;
+
+    const int bandCount = (image.height() + BAND_ROWS - 1) / BAND_ROWS;
+    QVector<Band> bands(bandCount);
+    QVector<int> indices(bandCount);
+    std::iota(indices.begin(), indices.end(), 0);
+    QtConcurrent::blockingMap(indices, [&](int index) {
+        scanBand(image, index * BAND_ROWS, qMin(image.height(), (index + 1) * BAND_ROWS), bands[index]);
+    });
+
+    // Bands are merged in order, so the hash is the same however they ran
+    stats.pixelCount = static_cast<qint64>(image.width()) * image.height();
+    stats.grayscale = true;
+    stats.opaque = true;
+    quint64 hash = avalanche(PRIME_3 ^ (static_cast<quint64>(image.width()) << 32) ^ image.height());
+    for (const Band &band : bands) {
+        for (int channel = 0; channel < ChannelCount; ++channel) {
+            const quint32 *counts = band.histogram[band.lumaOnly ? Luma : channel];
+            for (int value = 0; value < 256; ++value) {
+                stats.histogram[channel][value] += counts[value];
+            }
+        }
+        stats.grayscale = stats.grayscale && band.grayscale;
+        stats.opaque = stats.opaque && band.opaque;
+
+        quint64 bandHash = 0;
+        for (int lane = 0; lane < LANES; ++lane) {
+            bandHash += rotateLeft(band.lanes[lane], 1 + lane * 6);
+        }
+        hash = avalanche(hash ^ bandHash) * PRIME_1;
+    }
+    stats.contentHash = avalanche(hash);
+
+    // Range and mean come from the histograms
+    for (int channel = 0; channel < ChannelCount; ++channel) {
+        const qint64 *counts = stats.histogram[channel];
+        int low = 0;
+        while (low < 255 && counts[low] == 0) ++low;
+        int high = 255;
+        while (high > 0 && counts[high] == 0) --high;
+
+        double sum = 0.0;
+        for (int value = low; value <= high; ++value) {
+            sum += static_cast<double>(value) * counts[value];
+        }
+        stats.minimum[channel] = low;
+        stats.maximum[channel] = high;
+        stats.mean[channel] = sum / stats.pixelCount;
+    }
+    return stats;
+}
@@ -0,0 +1,49 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#ifndef IMAGESTATS_H
+#define IMAGESTATS_H
+
+#include <QImage>
+
+// Per-image statistics gathered in one pass over freshly decoded pixels.
+//
+// Histograms, the content hash and the grey/opaque flags ImageLoader::compact
+// needs are all collected in the same visit to each pixel; value ranges and
+// means are then read off the histograms rather than from another pass.
+// Row bands run on the global thread pool. The hash covers the pixels as
+// non-premultiplied ARGB, so the same picture hashes the same whatever
+// format it was decoded into or is stored in.
+class ImageStats
+{
+public:
+    enum Channel {
+        Red,
+        Green,
+        Blue,
+        Luma,  // Rec. 601 weights, integer approximation
+        ChannelCount
+    };
+
+    ImageStats();
+
+    static ImageStats compute(const QImage &image);
+
+    bool isValid() const { return pixelCount > 0; }
+
+    qint64 pixelCount;
+    quint64 contentHash;
+    bool grayscale;  // every pixel has R == G == B
+    bool opaque;     // every pixel has alpha 255
+    qint64 histogram[ChannelCount][256];
+    int minimum[ChannelCount];
+    int maximum[ChannelCount];
+    double mean[ChannelCount];
+
+    static const int BAND_ROWS = 64; // fixed, so the hash does not depend on the thread count
+};
+
+#endif // IMAGESTATS_H
@@ -0,0 +1,103 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#include "instanceserver.h"
+
+InstanceServer::InstanceServer(QObject *parent)
+    : QObject(parent)
+    , server(nullptr)
+{
+    server = new QLocalServer(this);
+    server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(server, &QLocalServer::newConnection, this, &InstanceServer::onNewConnection);
+}
+
+QString InstanceServer::serverName()
+{
+    // One instance per user; the user name keeps sessions on shared machines apart
+    QString user = qEnvironmentVariable("USER", qEnvironmentVariable("USERNAME", "default"));
+    return QString("PhotoCompare-%1").arg(user);
+}
+
+QString InstanceServer::joinCommand(const QStringList &arguments)
+{
+    return arguments.join('\t');
+}
+
+QStringList InstanceServer::splitCommand(const QString &line)
+{
+    // Tabs keep paths with spaces intact; plain spaces are handy when typing by hand
+    if (line.contains('\t')) {
+        return line.split('\t');
+    }
+    return line.split(' ', Qt::SkipEmptyParts);
+}
+
+bool InstanceServer::listen()
+{
+    if (server->listen(serverName())) return true;
+    if (server->serverError() != QAbstractSocket::AddressInUseError) return false;
+
+    // Either another instance won the race or a crashed one left its socket
+    // behind; only clear the name when nobody answers on it
+    QLocalSocket probe;
+    probe.connectToServer(serverName());
+    if (probe.waitForConnected(CONNECT_TIMEOUT_MS)) return false;
+
+    QLocalServer::removeServer(serverName());
+    return server->listen(serverName());
+}
+
+void InstanceServer::setCommandHandler(const CommandHandler &handler)
+{
+    commandHandler = handler;
+}
+
+void InstanceServer::onNewConnection()
+{
+    while (QLocalSocket *socket = server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() {
+            handleLines(socket);
+        });
+        connect(socket, &QLocalSocket::disconnected, socket, &QLocalSocket::deleteLater);
+        handleLines(socket);
+    }
+}
+
+void InstanceServer::handleLines(QLocalSocket *socket)
+{
+    while (socket->canReadLine()) {
+        QString line = QString::fromUtf8(socket->readLine()).trimmed();
+        if (line.isEmpty()) continue;
+
+        QStringList arguments = splitCommand(line);
+        QString error = commandHandler ? commandHandler(arguments) : QString("no command handler");
+        socket->write(error.isEmpty() ? QByteArray("ok\n") : ("error " + error.toUtf8() + "\n"));
+    }
+    socket->flush();
+}
+
+bool InstanceServer::sendCommands(const QStringList &commands, QStringList *replies)
+{
+    QLocalSocket socket;
+    socket.connectToServer(serverName());
+    if (!socket.waitForConnected(CONNECT_TIMEOUT_MS)) return false;
+
+    for (const QString &command : commands) {
+        socket.write(command.toUtf8() + '\n');
+    }
+    socket.flush();
+
+    // One reply line per command, in order
+    while (replies->size() < commands.size()) {
+        if (!socket.canReadLine() && !socket.waitForReadyRead(REPLY_TIMEOUT_MS)) break;
+        while (socket.canReadLine()) {
+            replies->append(QString::fromUtf8(socket.readLine()).trimmed());
+        }
+    }
+    socket.disconnectFromServer();
+    return true;
+}
@@ -0,0 +1,64 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#ifndef INSTANCESERVER_H
+#define INSTANCESERVER_H
+
+#include <QObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QStringList>
+#include <functional>
+
+// Local socket endpoint of a single-instance window. Clients send one
+// command per line (UTF-8, arguments separated by tabs, or by spaces when a
+// line has no tab) and receive one reply line per command: "ok" or
+// "error <message>". Commands:
+//
+//   set-pair <first> <second>
+//   set-first <first>
+//   set-mode wipe|dissolve|difference|flip
+//   set-direction left-to-right|right-to-left|top-to-bottom|bottom-to-top
+//   set-zoom <factor>
+//   match-folders <first-dir> <second-dir>
+//   set-sequence on|off
+//   play, pause, seek <frame>
+//   raise
+class InstanceServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Returns an error message, or an empty string on success
+    using CommandHandler = std::function<QString(const QStringList &arguments)>;
+
+    explicit InstanceServer(QObject *parent = nullptr);
+
+    bool listen();
+    void setCommandHandler(const CommandHandler &handler);
+
+    // Deliver commands to a running instance. Returns false when no instance
+    // is listening; replies holds one line per command otherwise.
+    static bool sendCommands(const QStringList &commands, QStringList *replies);
+
+    static QString serverName();
+    static QString joinCommand(const QStringList &arguments);
+    static QStringList splitCommand(const QString &line);
+
+private slots:
+    void onNewConnection();
+
+private:
+    void handleLines(QLocalSocket *socket);
+
+    QLocalServer *server;
+    CommandHandler commandHandler;
+
+    static const int CONNECT_TIMEOUT_MS = 500;
+    static const int REPLY_TIMEOUT_MS = 5000;
+};
+
+#endif // INSTANCESERVER_H
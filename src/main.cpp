@@ -9,10 +9,260 @@
 #include <QCommandLineOption>
 #include <QFileInfo>
 #include <QMessageBox>
+#include <QElapsedTimer>
+#include <QDebug>
 #include "mainwindow.h"
+#include "instanceserver.h"
+#include "framestream.h"
+#include "regressioncheck.h"
+#include "deepzoomexport.h"
+#include <QTextStream>
+
+namespace {
+
+void setupParser(QCommandLineParser &parser)
+{
+    parser.setApplicationDescription("A tool for comparing two images with wipe and dissolve modes");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    
+    // Add positional arguments for the two image files
+    parser.addPositionalArgument("image1", "Path to the first image file (or reference folder)");
+    parser.addPositionalArgument("image2", "Path to the second image file (or candidate folder)");
+    
+    parser.addOption(QCommandLineOption(QStringList() << "s" << "single-instance",
+        "Reuse a running Photo Compare window, forwarding images and options to it"));
+    parser.addOption(QCommandLineOption("mode", "Comparison mode: wipe, dissolve, difference or flip", "mode"));
+    parser.addOption(QCommandLineOption("direction",
+        "Wipe direction: left-to-right, right-to-left, top-to-bottom or bottom-to-top", "direction"));
+    parser.addOption(QCommandLineOption("zoom", "Zoom factor relative to fit-to-window", "factor"));
+    parser.addOption(QCommandLineOption("sequence",
+        "Play numbered files (frame_0001.png...) as sequences; multi-frame GIF/TIFF always play"));
+    parser.addOption(QCommandLineOption("stream",
+        "Read raw frames from - (stdin) or shm:<name> (POSIX shared memory), see README", "source"));
+    parser.addOption(QCommandLineOption("check",
+        "Compare image1 and image2 without a window; exit 0 on pass, 1 on failure, 2 on error"));
+    parser.addOption(QCommandLineOption("threshold",
+        "With --check: per-channel difference (0-255) tolerated per pixel", "value", "0"));
+    parser.addOption(QCommandLineOption("perceptual",
+        "With --check: compare by YIQ color distance with this tolerance (0-1, e.g. 0.1) "
+        "and ignore anti-aliased edges", "tolerance"));
+    parser.addOption(QCommandLineOption("include-aa",
+        "With --check --perceptual: count anti-aliased pixels as differences"));
+    parser.addOption(QCommandLineOption("max-diff",
+        "With --check: differing pixels allowed, as a count or a percentage (e.g. 0.1%)", "budget", "0"));
+    parser.addOption(QCommandLineOption("diff-output",
+        "With --check: where to write the diff image on failure", "path"));
+    parser.addOption(QCommandLineOption("write-diffmap",
+        "With --check: save the change map and counts beside image2 (image2.pcdiff) for the viewer"));
+    parser.addOption(QCommandLineOption("export-dzi",
+        "Write image1 and image2 as deep zoom tiles with an HTML viewer into directory, without a window",
+        "directory"));
+    parser.addOption(QCommandLineOption("export-diff",
+        "With --export-dzi: add a perceptual difference layer (tolerance from --perceptual, default 0.1)"));
+    parser.addOption(QCommandLineOption("command",
+        "Send a raw instance command (see README) to the running window; may be repeated", "command"));
+}
+
+// Option commands, shared by the local window and forwarding to a running one
+QStringList optionCommands(const QCommandLineParser &parser)
+{
+    QStringList commands;
+    if (parser.isSet("mode")) {
+        commands << InstanceServer::joinCommand({"set-mode", parser.value("mode")});
+    }
+    if (parser.isSet("direction")) {
+        commands << InstanceServer::joinCommand({"set-direction", parser.value("direction")});
+    }
+    if (parser.isSet("zoom")) {
+        commands << InstanceServer::joinCommand({"set-zoom", parser.value("zoom")});
+    }
+    if (parser.isSet("sequence")) {
+        commands << InstanceServer::joinCommand({"set-sequence", "on"});
+    }
+    return commands;
+}
+
+bool hasArgument(int argc, char *argv[], const char *name)
+{
+    const QByteArray withValue = QByteArray(name) + '=';
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], name) == 0 || QByteArray(argv[i]).startsWith(withValue)) return true;
+    }
+    return false;
+}
+
+int runCheck(const QCommandLineParser &parser)
+{
+    QTextStream out(stdout);
+    const QStringList args = parser.positionalArguments();
+    if (args.size() != 2) {
+        out << "ERROR: --check needs exactly two images" << Qt::endl;
+        return RegressionCheck::Error;
+    }
+    
+    RegressionCheck::Options options;
+    bool ok = false;
+    options.threshold = parser.value("threshold").toInt(&ok);
+    if (!ok || options.threshold < 0 || options.threshold > 255) {
+        out << "ERROR: --threshold must be between 0 and 255" << Qt::endl;
+        return RegressionCheck::Error;
+    }
+    
+    if (parser.isSet("perceptual")) {
+        options.perceptualThreshold = parser.value("perceptual").toDouble(&ok);
+        if (!ok || options.perceptualThreshold < 0.0 || options.perceptualThreshold > 1.0) {
+            out << "ERROR: --perceptual must be between 0 and 1" << Qt::endl;
+            return RegressionCheck::Error;
+        }
+    }
+    options.includeAntiAliasing = parser.isSet("include-aa");
+    
+    QString budget = parser.value("max-diff");
+    if (budget.endsWith('%')) {
+        options.maxDifferentRatio = budget.chopped(1).toDouble(&ok) / 100.0;
+    } else {
+        options.maxDifferentPixels = budget.toLongLong(&ok);
+    }
+    if (!ok || options.maxDifferentPixels < 0 || (budget.endsWith('%') && options.maxDifferentRatio < 0.0)) {
+        out << "ERROR: --max-diff must be a pixel count or a percentage" << Qt::endl;
+        return RegressionCheck::Error;
+    }
+    options.diffOutputPath = parser.value("diff-output");
+    options.writeSidecar = parser.isSet("write-diffmap");
+    
+    QString message;
+    RegressionCheck::ExitCode result = RegressionCheck::run(args.at(0), args.at(1), options, &message);
+    out << message << Qt::endl;
+    return result;
+}
+
+int runExport(const QCommandLineParser &parser)
+{
+    QTextStream out(stdout);
+    const QStringList args = parser.positionalArguments();
+    if (args.size() != 2) {
+        out << "ERROR: --export-dzi needs exactly two images" << Qt::endl;
+        return 1;
+    }
+    
+    DeepZoomExport::Options options;
+    options.includeDifference = parser.isSet("export-diff");
+    if (parser.isSet("perceptual")) {
+        bool ok = false;
+        options.differenceOptions.threshold = parser.value("perceptual").toDouble(&ok);
+        if (!ok || options.differenceOptions.threshold < 0.0 || options.differenceOptions.threshold > 1.0) {
+            out << "ERROR: --perceptual must be between 0 and 1" << Qt::endl;
+            return 1;
+        }
+    }
+    options.differenceOptions.includeAntiAliasing = parser.isSet("include-aa");
+    
+    QString message;
+    bool exported = DeepZoomExport::run(args.at(0), args.at(1), parser.value("export-dzi"), options, &message);
+    out << message << Qt::endl;
+    return exported ? 0 : 1;
+}
+
+bool wantsSingleInstance(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        const QByteArray argument(argv[i]);
+        if (argument == "-s" || argument == "--single-instance" || argument.startsWith("--command")) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns the process exit code for a forwarded invocation
+int forwardToRunningInstance(const QCommandLineParser &parser, bool *forwarded)
+{
+    QStringList commands;
+    const QStringList args = parser.positionalArguments();
+    if (args.size() >= 2) {
+        bool folders = QFileInfo(args.at(0)).isDir() && QFileInfo(args.at(1)).isDir();
+        commands << InstanceServer::joinCommand({folders ? "match-folders" : "set-pair",
+                                                 QFileInfo(args.at(0)).absoluteFilePath(),
+                                                 QFileInfo(args.at(1)).absoluteFilePath()});
+    } else if (args.size() == 1) {
+        // One image replaces the first side, as it does when starting a window
+        commands << InstanceServer::joinCommand({"set-first", QFileInfo(args.at(0)).absoluteFilePath()});
+    }
+    commands << optionCommands(parser) << parser.values("command");
+    commands << "raise";
+    
+    QStringList replies;
+    *forwarded = InstanceServer::sendCommands(commands, &replies);
+    if (!*forwarded) return 0;
+    
+    int exitCode = 0;
+    for (int i = 0; i < commands.size(); ++i) {
+        QString reply = i < replies.size() ? replies.at(i) : QString("error no reply");
+        if (reply != "ok") {
+            qWarning().noquote() << commands.at(i).section('\t', 0, 0) + ":" << reply;
+            exitCode = 1;
+        }
+    }
+    return exitCode;
+}
+
+} // namespace
 
 int main(int argc, char *argv[])
 {
+    // Cold-start-to-first-pixel is measured from here
+    QElapsedTimer launchTimer;
+    launchTimer.start();
+    
+    // Headless visual-regression check: no window, the exit code is the verdict
+    if (hasArgument(argc, argv, "--check")) {
+        QCoreApplication checker(argc, argv);
+        checker.setApplicationName("Photo Compare");
+        checker.setApplicationVersion("1.0");
+        QCommandLineParser parser;
+        setupParser(parser);
+        
+        // process() exits with 1 on a bad option, which CI would read as a
+        // failed comparison; usage errors get the Error code instead
+        if (!parser.parse(checker.arguments())) {
+            QTextStream(stdout) << "ERROR: " << parser.errorText() << Qt::endl;
+            return RegressionCheck::Error;
+        }
+        if (parser.isSet("help")) {
+            parser.showHelp(0);
+        }
+        if (parser.isSet("version")) {
+            parser.showVersion();
+        }
+        return runCheck(parser);
+    }
+    
+    // Headless deep zoom export
+    if (hasArgument(argc, argv, "--export-dzi")) {
+        QCoreApplication exporter(argc, argv);
+        exporter.setApplicationName("Photo Compare");
+        exporter.setApplicationVersion("1.0");
+        QCommandLineParser parser;
+        setupParser(parser);
+        parser.process(exporter);
+        return runExport(parser);
+    }
+    
+    // Hand off to a running instance before paying for GUI startup
+    if (wantsSingleInstance(argc, argv)) {
+        QCoreApplication forwarder(argc, argv);
+        QCommandLineParser parser;
+        setupParser(parser);
+        if (parser.parse(forwarder.arguments()) && !parser.isSet("help") && !parser.isSet("version")) {
+            bool forwarded = false;
+            int exitCode = forwardToRunningInstance(parser, &forwarded);
+            if (forwarded) {
+                return exitCode;
+            }
+        }
+    }
+    
     QApplication app(argc, argv);
     app.setApplicationName("Photo Compare");
     app.setApplicationVersion("1.0");
@@ -20,13 +270,7 @@ int main(int argc, char *argv[])
     
     // Set up command line parser
     QCommandLineParser parser;
-    parser.setApplicationDescription("A tool for comparing two images with wipe and dissolve modes");
-    parser.addHelpOption();
-    parser.addVersionOption();
-    
-    // Add positional arguments for the two image files
-    parser.addPositionalArgument("image1", "Path to the first image file");
-    parser.addPositionalArgument("image2", "Path to the second image file");
+    setupParser(parser);
     
     // Process command line arguments
     parser.process(app);
@@ -34,27 +278,30 @@ int main(int argc, char *argv[])
     // Get positional arguments
     const QStringList args = parser.positionalArguments();
     
+    // Two folders: pair their images by content and review the matches
+    bool matchingFolders = args.size() >= 2 && QFileInfo(args.at(0)).isDir() && QFileInfo(args.at(1)).isDir();
+    
     QString firstImagePath;
     QString secondImagePath;
     
     // Check if images were provided as arguments
-    if (args.size() >= 1) {
+    if (args.size() >= 1 && !matchingFolders) {
         firstImagePath = args.at(0);
         // Validate first image file
         QFileInfo firstFile(firstImagePath);
         if (!firstFile.exists() || !firstFile.isFile()) {
-            QMessageBox::critical(nullptr, "Error", 
+            QMessageBox::critical(nullptr, "Error",
                 QString("First image file does not exist: %1").arg(firstImagePath));
             return 1;
         }
     }
     
-    if (args.size() >= 2) {
+    if (args.size() >= 2 && !matchingFolders) {
         secondImagePath = args.at(1);
         // Validate second image file
         QFileInfo secondFile(secondImagePath);
         if (!secondFile.exists() || !secondFile.isFile()) {
-            QMessageBox::critical(nullptr, "Error", 
+            QMessageBox::critical(nullptr, "Error",
                 QString("Second image file does not exist: %1").arg(secondImagePath));
             return 1;
         }
@@ -62,13 +309,46 @@ int main(int argc, char *argv[])
     
     // Create and show main window
     MainWindow window;
+    window.setLaunchTimer(launchTimer);
     
     // Load images if provided
-    if (!firstImagePath.isEmpty()) {
+    if (matchingFolders) {
+        window.matchFolders(args.at(0), args.at(1));
+    } else if (!firstImagePath.isEmpty() && !secondImagePath.isEmpty()) {
+        window.loadPair(firstImagePath, secondImagePath);
+    } else if (!firstImagePath.isEmpty()) {
         window.loadFirstImage(firstImagePath);
     }
-    if (!secondImagePath.isEmpty()) {
-        window.loadSecondImage(secondImagePath);
+    
+    // Apply mode, direction and zoom options the same way a forwarded call would
+    const QStringList commands = optionCommands(parser) + parser.values("command");
+    for (const QString &command : commands) {
+        QString error = window.executeCommand(InstanceServer::splitCommand(command));
+        if (!error.isEmpty()) {
+            qWarning().noquote() << error;
+        }
+    }
+    
+    // Raw frames replace one side of the comparison as they arrive
+    FrameStream frameStream;
+    if (parser.isSet("stream")) {
+        QString error;
+        if (!frameStream.open(parser.value("stream"), &error)) {
+            QMessageBox::critical(nullptr, "Error", error);
+            return 1;
+        }
+        QObject::connect(&frameStream, &FrameStream::frameReceived, &window, &MainWindow::showStreamFrame);
+    }
+    
+    // Become the instance later invocations forward to
+    InstanceServer instanceServer;
+    if (wantsSingleInstance(argc, argv)) {
+        instanceServer.setCommandHandler([&window](const QStringList &arguments) {
+            return window.executeCommand(arguments);
+        });
+        if (!instanceServer.listen()) {
+            qWarning().noquote() << "Could not listen for other instances on" << InstanceServer::serverName();
+        }
     }
     
     window.show();
@@ -5,6 +5,35 @@
 //  See the LICENSE file for full details
 //===========================================
 #include "mainwindow.h"
+#include "imageloader.h"
+#include "deepzoomexport.h"
+#include <QStatusBar>
+#include <QtConcurrent/QtConcurrentRun>
+
+namespace {
+
+QString formatName(QImage::Format format)
+{
+    switch (format) {
+        case QImage::Format_Mono:
+        case QImage::Format_MonoLSB: return "1-bit";
+        case QImage::Format_Indexed8: return "indexed";
+        case QImage::Format_Grayscale8: return "Gray8";
+        case QImage::Format_Grayscale16: return "Gray16";
+        case QImage::Format_RGB888: return "RGB888";
+        case QImage::Format_RGB32: return "RGB32";
+        case QImage::Format_ARGB32:
+        case QImage::Format_ARGB32_Premultiplied: return "ARGB32";
+        case QImage::Format_RGBA8888:
+        case QImage::Format_RGBA8888_Premultiplied: return "RGBA8888";
+        case QImage::Format_RGBX64:
+        case QImage::Format_RGBA64:
+        case QImage::Format_RGBA64_Premultiplied: return "RGBA64";
+        default: return QString("format %1").arg(static_cast<int>(format));
+    }
+}
+
+} // namespace
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -16,6 +45,13 @@ MainWindow::MainWindow(QWidget *parent)
     , secondImageButton(nullptr)
     , firstImageLabel(nullptr)
     , secondImageLabel(nullptr)
+    , matchFoldersButton(nullptr)
+    , sequenceCheckBox(nullptr)
+    , matchWatcher(nullptr)
+    , pairStrip(nullptr)
+    , pairModel(nullptr)
+    , exportButton(nullptr)
+    , exportWatcher(nullptr)
     , modeControlsLayout(nullptr)
     , wipeLayout(nullptr)
     , wipeModeRadio(nullptr)
@@ -27,7 +63,20 @@ MainWindow::MainWindow(QWidget *parent)
     , transitionTimeLabel(nullptr)
     , transitionTimeSpinBox(nullptr)
     , dissolveToggleButton(nullptr)
+    , differenceLayout(nullptr)
+    , differenceModeRadio(nullptr)
+    , toleranceLabel(nullptr)
+    , toleranceSpinBox(nullptr)
+    , antiAliasingCheckBox(nullptr)
+    , flipLayout(nullptr)
+    , flipModeRadio(nullptr)
     , modeGroup(nullptr)
+    , playbackBar(nullptr)
+    , playButton(nullptr)
+    , frameSlider(nullptr)
+    , frameLabel(nullptr)
+    , fpsSpinBox(nullptr)
+    , sequencePlayer(nullptr)
     , compareWidget(nullptr)
     , isDissolving(false)
 {
@@ -77,8 +126,25 @@ void MainWindow::setupUI()
     secondImageLayout->addWidget(secondImageLabel);
     secondImageLayout->addStretch();
     
+    // Folder matching row
+    QHBoxLayout *pairLayout = new QHBoxLayout();
+    matchFoldersButton = new QPushButton("Match Folders...", this);
+    matchFoldersButton->setMaximumWidth(150);
+    
+    sequenceCheckBox = new QCheckBox("Numbered frames as sequence", this);
+    
+    exportButton = new QPushButton("Export Deep Zoom...", this);
+    exportButton->setMaximumWidth(150);
+    exportButton->setToolTip("Write both images as deep zoom tiles with an HTML viewer for sharing");
+    
+    pairLayout->addWidget(matchFoldersButton);
+    pairLayout->addWidget(sequenceCheckBox);
+    pairLayout->addWidget(exportButton);
+    pairLayout->addStretch();
+    
     imageControlsLayout->addLayout(firstImageLayout);
     imageControlsLayout->addLayout(secondImageLayout);
+    imageControlsLayout->addLayout(pairLayout);
     
     // Right side - Mode controls (stacked)
     modeControlsLayout = new QVBoxLayout();
@@ -131,13 +197,46 @@ void MainWindow::setupUI()
     dissolveLayout->addWidget(dissolveToggleButton);
     dissolveLayout->addStretch();
     
+    // Difference mode row
+    differenceLayout = new QHBoxLayout();
+    differenceModeRadio = new QRadioButton("Difference", this);
+    
+    toleranceLabel = new QLabel("Tolerance:", this);
+    toleranceSpinBox = new QDoubleSpinBox(this);
+    toleranceSpinBox->setRange(0.0, 1.0);
+    toleranceSpinBox->setSingleStep(0.05);
+    toleranceSpinBox->setValue(PerceptualDiff::DEFAULT_THRESHOLD);
+    toleranceSpinBox->setDecimals(2);
+    toleranceSpinBox->setMaximumWidth(60);
+    
+    antiAliasingCheckBox = new QCheckBox("Count anti-aliasing", this);
+    
+    differenceLayout->addWidget(differenceModeRadio);
+    differenceLayout->addWidget(toleranceLabel);
+    differenceLayout->addWidget(toleranceSpinBox);
+    differenceLayout->addWidget(antiAliasingCheckBox);
+    differenceLayout->addStretch();
+    
     modeControlsLayout->addLayout(wipeLayout);
     modeControlsLayout->addLayout(dissolveLayout);
     
+    // Flip mode row
+    flipLayout = new QHBoxLayout();
+    flipModeRadio = new QRadioButton("Flip", this);
+    flipModeRadio->setToolTip("Tap Space to switch between the images, hold it to peek at the other one");
+    flipLayout->addWidget(flipModeRadio);
+    flipLayout->addWidget(new QLabel("Tap or hold Space to switch images", this));
+    flipLayout->addStretch();
+    
+    modeControlsLayout->addLayout(differenceLayout);
+    modeControlsLayout->addLayout(flipLayout);
+    
     // Set up radio button group
     modeGroup = new QButtonGroup(this);
     modeGroup->addButton(wipeModeRadio);
     modeGroup->addButton(dissolveModeRadio);
+    modeGroup->addButton(differenceModeRadio);
+    modeGroup->addButton(flipModeRadio);
     wipeModeRadio->setChecked(true); // Default selection
     
     // Initially enable wipe controls and disable dissolve controls
@@ -145,16 +244,50 @@ void MainWindow::setupUI()
     holdTimeSpinBox->setEnabled(false);
     transitionTimeSpinBox->setEnabled(false);
     dissolveToggleButton->setEnabled(false);
+    toleranceSpinBox->setEnabled(false);
+    antiAliasingCheckBox->setEnabled(false);
     
     // Add left and right sides to main controls layout
     controlsLayout->addLayout(imageControlsLayout, 1);
     controlsLayout->addLayout(modeControlsLayout, 1);
     
+    // Playback row, hidden until a sequence is loaded
+    playbackBar = new QWidget(this);
+    QHBoxLayout *playbackLayout = new QHBoxLayout(playbackBar);
+    playbackLayout->setContentsMargins(0, 0, 0, 0);
+    playButton = new QPushButton("Play", playbackBar);
+    playButton->setMaximumWidth(60);
+    frameSlider = new QSlider(Qt::Horizontal, playbackBar);
+    frameLabel = new QLabel(playbackBar);
+    fpsSpinBox = new QDoubleSpinBox(playbackBar);
+    fpsSpinBox->setRange(1.0, 240.0);
+    fpsSpinBox->setValue(24.0);
+    fpsSpinBox->setDecimals(1);
+    fpsSpinBox->setSuffix(" fps");
+    fpsSpinBox->setMaximumWidth(90);
+    
+    playbackLayout->addWidget(playButton);
+    playbackLayout->addWidget(frameSlider, 1);
+    playbackLayout->addWidget(frameLabel);
+    playbackLayout->addWidget(fpsSpinBox);
+    playbackBar->setVisible(false);
+    
+    sequencePlayer = new SequencePlayer(this);
+    sequencePlayer->setFrameRate(fpsSpinBox->value());
+    
     // Create image compare widget
     compareWidget = new ImageCompareWidget(this);
     
+    // Filmstrip of matched pairs
+    pairModel = new PairStripModel(this);
+    pairStrip = new PairStrip(this);
+    pairStrip->setPairModel(pairModel);
+    pairStrip->setVisible(false);
+    
     // Add everything to main layout
     mainLayout->addLayout(controlsLayout);
+    mainLayout->addWidget(pairStrip);
+    mainLayout->addWidget(playbackBar);
     mainLayout->addWidget(compareWidget, 1); // Give it stretch factor of 1
     
     // Connect signals
@@ -163,9 +296,30 @@ void MainWindow::setupUI()
     connect(directionComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::onDirectionChanged);
     connect(wipeModeRadio, &QRadioButton::toggled, this, &MainWindow::onCompareModeChanged);
     connect(dissolveModeRadio, &QRadioButton::toggled, this, &MainWindow::onCompareModeChanged);
+    connect(differenceModeRadio, &QRadioButton::toggled, this, &MainWindow::onCompareModeChanged);
+    connect(flipModeRadio, &QRadioButton::toggled, this, &MainWindow::onCompareModeChanged);
+    connect(toleranceSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &MainWindow::onDifferenceSettingsChanged);
+    connect(antiAliasingCheckBox, &QCheckBox::toggled, this, &MainWindow::onDifferenceSettingsChanged);
+    connect(sequenceCheckBox, &QCheckBox::toggled, this, &MainWindow::setupSequences);
+    connect(playButton, &QPushButton::clicked, this, &MainWindow::onPlayToggle);
+    connect(frameSlider, &QSlider::valueChanged, sequencePlayer, &SequencePlayer::seek);
+    connect(fpsSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), sequencePlayer, &SequencePlayer::setFrameRate);
+    connect(sequencePlayer, &SequencePlayer::frameChanged, this, &MainWindow::onSequenceFrame);
+    connect(sequencePlayer, &SequencePlayer::playingChanged, this, &MainWindow::onPlayingChanged);
+    connect(compareWidget, &ImageCompareWidget::imagesChanged, this, &MainWindow::updateMemoryStatus);
     connect(holdTimeSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &MainWindow::onDissolveSettingsChanged);
     connect(transitionTimeSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &MainWindow::onDissolveSettingsChanged);
     connect(dissolveToggleButton, &QPushButton::clicked, this, &MainWindow::onDissolveToggle);
+    connect(matchFoldersButton, &QPushButton::clicked, this, &MainWindow::selectFolders);
+    connect(exportButton, &QPushButton::clicked, this, &MainWindow::exportDeepZoom);
+    connect(pairStrip, &PairStrip::pairSelected, this, &MainWindow::onPairSelected);
+    
+    // Folder matching runs off the GUI thread
+    matchWatcher = new QFutureWatcher<QList<ImagePair>>(this);
+    connect(matchWatcher, &QFutureWatcher<QList<ImagePair>>::finished, this, &MainWindow::onMatchFinished);
+    
+    exportWatcher = new QFutureWatcher<QString>(this);
+    connect(exportWatcher, &QFutureWatcher<QString>::finished, this, &MainWindow::onExportFinished);
 }
 
 void MainWindow::selectFirstImage()
@@ -173,7 +327,7 @@ void MainWindow::selectFirstImage()
     QString fileName = QFileDialog::getOpenFileName(this,
         "Select First Image",
         "",
-        "Image Files (*.png *.jpg *.jpeg *.bmp *.gif *.tiff)");
+        QString("Image Files (%1)").arg(ImageLoader::imageNameFilters().join(' ')));
     
     if (!fileName.isEmpty()) {
         firstImagePath = fileName;
@@ -189,7 +343,7 @@ void MainWindow::selectSecondImage()
     QString fileName = QFileDialog::getOpenFileName(this,
         "Select Second Image",
         "",
-        "Image Files (*.png *.jpg *.jpeg *.bmp *.gif *.tiff)");
+        QString("Image Files (%1)").arg(ImageLoader::imageNameFilters().join(' ')));
     
     if (!fileName.isEmpty()) {
         secondImagePath = fileName;
@@ -202,19 +356,43 @@ void MainWindow::selectSecondImage()
 
 void MainWindow::onDirectionChanged()
 {
-    updateCompareWidget();
+    // Only the wipe edge moves; the pair, its sequences and playback are kept
+    applyDirection();
+}
+
+void MainWindow::applyDirection()
+{
+    switch (directionComboBox->currentIndex()) {
+        case 1:
+            compareWidget->setDirection(ImageCompareWidget::RightToLeft);
+            break;
+        case 2:
+            compareWidget->setDirection(ImageCompareWidget::TopToBottom);
+            break;
+        case 3:
+            compareWidget->setDirection(ImageCompareWidget::BottomToTop);
+            break;
+        default:
+            compareWidget->setDirection(ImageCompareWidget::LeftToRight);
+            break;
+    }
 }
 
-void MainWindow::onCompareModeChanged()
+void MainWindow::onCompareModeChanged(bool checked)
 {
+    // Each switch toggles two radio buttons; act once, for the one turned on
+    if (!checked) return;
+    
     if (wipeModeRadio->isChecked()) {
         compareWidget->setCompareMode(ImageCompareWidget::WipeMode);
         
-        // Enable wipe controls, disable dissolve controls
+        // Enable wipe controls, disable dissolve and difference controls
         directionComboBox->setEnabled(true);
         holdTimeSpinBox->setEnabled(false);
         transitionTimeSpinBox->setEnabled(false);
         dissolveToggleButton->setEnabled(false);
+        toleranceSpinBox->setEnabled(false);
+        antiAliasingCheckBox->setEnabled(false);
         
         // Stop dissolve if it's running
         if (isDissolving) {
@@ -225,17 +403,63 @@ void MainWindow::onCompareModeChanged()
     } else if (dissolveModeRadio->isChecked()) {
         compareWidget->setCompareMode(ImageCompareWidget::DissolveMode);
         
-        // Disable wipe controls, enable dissolve controls
+        // Disable wipe and difference controls, enable dissolve controls
         directionComboBox->setEnabled(false);
         holdTimeSpinBox->setEnabled(true);
         transitionTimeSpinBox->setEnabled(true);
+        toleranceSpinBox->setEnabled(false);
+        antiAliasingCheckBox->setEnabled(false);
         
         // Enable dissolve button only if images are loaded
         bool hasImages = !firstImagePath.isEmpty() && !secondImagePath.isEmpty();
         dissolveToggleButton->setEnabled(hasImages);
+    } else if (differenceModeRadio->isChecked()) {
+        onDifferenceSettingsChanged();
+        compareWidget->setCompareMode(ImageCompareWidget::DifferenceMode);
+        
+        // Only the difference settings apply
+        directionComboBox->setEnabled(false);
+        holdTimeSpinBox->setEnabled(false);
+        transitionTimeSpinBox->setEnabled(false);
+        dissolveToggleButton->setEnabled(false);
+        toleranceSpinBox->setEnabled(true);
+        antiAliasingCheckBox->setEnabled(true);
+        
+        // Stop dissolve if it's running
+        if (isDissolving) {
+            compareWidget->stopDissolve();
+            isDissolving = false;
+            dissolveToggleButton->setText("Start");
+        }
+    } else if (flipModeRadio->isChecked()) {
+        compareWidget->setCompareMode(ImageCompareWidget::FlipMode);
+        
+        // Flip has no settings; Space goes to the view, not the radio button
+        directionComboBox->setEnabled(false);
+        holdTimeSpinBox->setEnabled(false);
+        transitionTimeSpinBox->setEnabled(false);
+        dissolveToggleButton->setEnabled(false);
+        toleranceSpinBox->setEnabled(false);
+        antiAliasingCheckBox->setEnabled(false);
+        compareWidget->setFocus();
+        
+        // Stop dissolve if it's running
+        if (isDissolving) {
+            compareWidget->stopDissolve();
+            isDissolving = false;
+            dissolveToggleButton->setText("Start");
+        }
     }
 }
 
+void MainWindow::onDifferenceSettingsChanged()
+{
+    PerceptualDiff::Options options;
+    options.threshold = toleranceSpinBox->value();
+    options.includeAntiAliasing = antiAliasingCheckBox->isChecked();
+    compareWidget->setDifferenceSettings(options);
+}
+
 void MainWindow::onDissolveSettingsChanged()
 {
     double holdTime = holdTimeSpinBox->value();
@@ -288,36 +512,222 @@ void MainWindow::loadSecondImage(const QString &imagePath)
     }
 }
 
+void MainWindow::loadPair(const QString &firstPath, const QString &secondPath)
+{
+    if (firstPath.isEmpty() || secondPath.isEmpty()) return;
+    
+    // Set both sides before updating so the widget only loads the new pair once
+    firstImagePath = firstPath;
+    secondImagePath = secondPath;
+    setImageLabel(firstImageLabel, firstPath);
+    setImageLabel(secondImageLabel, secondPath);
+    updateCompareWidget();
+}
+
+void MainWindow::setImageLabel(QLabel *label, const QString &imagePath)
+{
+    QFileInfo fileInfo(imagePath);
+    label->setText(fileInfo.fileName());
+    label->setStyleSheet("color: black; font-style: normal;");
+}
+
+void MainWindow::setLaunchTimer(const QElapsedTimer &timer)
+{
+    compareWidget->setLaunchTimer(timer);
+}
+
+void MainWindow::showStreamFrame(int side, const QImage &image)
+{
+    QLabel *label = (side == 0) ? firstImageLabel : secondImageLabel;
+    label->setText(QString("Streamed frame (%1\u00d7%2)").arg(image.width()).arg(image.height()));
+    label->setStyleSheet("color: black; font-style: normal;");
+    
+    // Streamed frames take over from any file sequence
+    sequencePlayer->clear();
+    playbackBar->setVisible(false);
+    compareWidget->setImage(side, image);
+}
+
+QString MainWindow::executeCommand(const QStringList &arguments)
+{
+    if (arguments.isEmpty()) return "empty command";
+    
+    const QString command = arguments.at(0);
+    if (command == "set-pair") {
+        if (arguments.size() != 3) return "set-pair expects two paths";
+        for (int i = 1; i <= 2; ++i) {
+            if (!QFileInfo(arguments.at(i)).isFile()) {
+                return QString("image file does not exist: %1").arg(arguments.at(i));
+            }
+        }
+        loadPair(arguments.at(1), arguments.at(2));
+    } else if (command == "set-first") {
+        if (arguments.size() != 2) return "set-first expects one path";
+        if (!QFileInfo(arguments.at(1)).isFile()) {
+            return QString("image file does not exist: %1").arg(arguments.at(1));
+        }
+        loadFirstImage(arguments.at(1));
+    } else if (command == "set-mode") {
+        if (arguments.size() != 2) return "set-mode expects a mode";
+        if (arguments.at(1) == "wipe") {
+            wipeModeRadio->setChecked(true);
+        } else if (arguments.at(1) == "dissolve") {
+            dissolveModeRadio->setChecked(true);
+        } else if (arguments.at(1) == "difference") {
+            differenceModeRadio->setChecked(true);
+        } else if (arguments.at(1) == "flip") {
+            flipModeRadio->setChecked(true);
+        } else {
+            return QString("unknown mode: %1").arg(arguments.at(1));
+        }
+    } else if (command == "set-direction") {
+        const QStringList directions = {"left-to-right", "right-to-left", "top-to-bottom", "bottom-to-top"};
+        int index = arguments.size() == 2 ? directions.indexOf(arguments.at(1)) : -1;
+        if (index < 0) return "set-direction expects one of: " + directions.join(", ");
+        directionComboBox->setCurrentIndex(index);
+    } else if (command == "set-zoom") {
+        bool ok = false;
+        double factor = arguments.size() == 2 ? arguments.at(1).toDouble(&ok) : 0.0;
+        if (!ok || factor <= 0.0) return "set-zoom expects a positive factor";
+        compareWidget->setZoomFactor(factor);
+    } else if (command == "match-folders") {
+        if (arguments.size() != 3 || !QFileInfo(arguments.at(1)).isDir() || !QFileInfo(arguments.at(2)).isDir()) {
+            return "match-folders expects two folders";
+        }
+        matchFolders(arguments.at(1), arguments.at(2));
+    } else if (command == "set-sequence") {
+        if (arguments.size() != 2 || (arguments.at(1) != "on" && arguments.at(1) != "off")) {
+            return "set-sequence expects on or off";
+        }
+        sequenceCheckBox->setChecked(arguments.at(1) == "on");
+    } else if (command == "play" || command == "pause") {
+        if (sequencePlayer->frameCount() < 2) return "no sequence loaded";
+        if (command == "play") {
+            sequencePlayer->play();
+        } else {
+            sequencePlayer->pause();
+        }
+    } else if (command == "seek") {
+        bool ok = false;
+        int frame = arguments.size() == 2 ? arguments.at(1).toInt(&ok) : 0;
+        if (!ok || frame < 1 || frame > sequencePlayer->frameCount()) return "seek expects a frame number";
+        sequencePlayer->seek(frame - 1);
+    } else if (command == "raise") {
+        if (isMinimized()) {
+            showNormal();
+        }
+        raise();
+        activateWindow();
+    } else {
+        return QString("unknown command: %1").arg(command);
+    }
+    return QString();
+}
+
+void MainWindow::selectFolders()
+{
+    QString firstDir = QFileDialog::getExistingDirectory(this, "Select Reference Folder");
+    if (firstDir.isEmpty()) return;
+    
+    QString secondDir = QFileDialog::getExistingDirectory(this, "Select Candidate Folder");
+    if (secondDir.isEmpty()) return;
+    
+    matchFolders(firstDir, secondDir);
+}
+
+void MainWindow::matchFolders(const QString &firstDir, const QString &secondDir)
+{
+    if (matchWatcher->isRunning()) return;
+    
+    matchFoldersButton->setEnabled(false);
+    matchFoldersButton->setText("Matching...");
+    matchWatcher->setFuture(QtConcurrent::run([firstDir, secondDir]() {
+        return ImageMatcher::matchFolders(firstDir, secondDir);
+    }));
+}
+
+void MainWindow::onMatchFinished()
+{
+    matchFoldersButton->setEnabled(true);
+    matchFoldersButton->setText("Match Folders...");
+    
+    pairs = matchWatcher->result();
+    if (pairs.isEmpty()) {
+        QMessageBox::information(this, "Match Folders", "No matching images were found.");
+        return;
+    }
+    
+    // The strip only paints and loads thumbnails for what is in view, so
+    // large batches cost no more than small ones
+    pairModel->setPairs(pairs);
+    pairStrip->setVisible(true);
+    pairStrip->setCurrentIndex(pairModel->index(0));
+}
+
+void MainWindow::exportDeepZoom()
+{
+    if (exportWatcher->isRunning()) return;
+    if (firstImagePath.isEmpty() || secondImagePath.isEmpty()) {
+        QMessageBox::information(this, "Export Deep Zoom", "Select two images to export first.");
+        return;
+    }
+    
+    QString directory = QFileDialog::getExistingDirectory(this, "Select Export Folder");
+    if (directory.isEmpty()) return;
+    
+    // The difference layer uses the tolerance set for difference mode
+    DeepZoomExport::Options options;
+    options.includeDifference = true;
+    options.differenceOptions.threshold = toleranceSpinBox->value();
+    options.differenceOptions.includeAntiAliasing = antiAliasingCheckBox->isChecked();
+    
+    const QString first = firstImagePath;
+    const QString second = secondImagePath;
+    exportButton->setEnabled(false);
+    exportButton->setText("Exporting...");
+    exportWatcher->setFuture(QtConcurrent::run([first, second, directory, options]() {
+        QString message;
+        DeepZoomExport::run(first, second, directory, options, &message);
+        return message;
+    }));
+}
+
+void MainWindow::onExportFinished()
+{
+    exportButton->setEnabled(true);
+    exportButton->setText("Export Deep Zoom...");
+    
+    const QString message = exportWatcher->result();
+    if (message.startsWith("ERROR")) {
+        QMessageBox::warning(this, "Export Deep Zoom", message);
+    } else {
+        statusBar()->showMessage(message);
+    }
+}
+
+void MainWindow::onPairSelected(int index)
+{
+    if (index < 0 || index >= pairs.size()) return;
+    loadPair(pairs.at(index).firstPath, pairs.at(index).secondPath);
+}
+
 void MainWindow::updateCompareWidget()
 {
     if (!firstImagePath.isEmpty() && !secondImagePath.isEmpty()) {
         compareWidget->setImages(firstImagePath, secondImagePath);
         
         // Set direction based on combo box selection
-        int directionIndex = directionComboBox->currentIndex();
-        switch (directionIndex) {
-            case 0:
-                compareWidget->setDirection(ImageCompareWidget::LeftToRight);
-                break;
-            case 1:
-                compareWidget->setDirection(ImageCompareWidget::RightToLeft);
-                break;
-            case 2:
-                compareWidget->setDirection(ImageCompareWidget::TopToBottom);
-                break;
-            case 3:
-                compareWidget->setDirection(ImageCompareWidget::BottomToTop);
-                break;
-            default:
-                compareWidget->setDirection(ImageCompareWidget::LeftToRight);
-                break;
-        }
+        applyDirection();
         
         // Set compare mode
         if (wipeModeRadio->isChecked()) {
             compareWidget->setCompareMode(ImageCompareWidget::WipeMode);
         } else if (dissolveModeRadio->isChecked()) {
             compareWidget->setCompareMode(ImageCompareWidget::DissolveMode);
+        } else if (differenceModeRadio->isChecked()) {
+            compareWidget->setCompareMode(ImageCompareWidget::DifferenceMode);
+        } else if (flipModeRadio->isChecked()) {
+            compareWidget->setCompareMode(ImageCompareWidget::FlipMode);
         }
         
         // Update dissolve settings
@@ -331,4 +741,72 @@ void MainWindow::updateCompareWidget()
         // Disable dissolve button if no images
         dissolveToggleButton->setEnabled(false);
     }
+    
+    setupSequences();
+}
+
+void MainWindow::setupSequences()
+{
+    // Multi-frame files always play; numbered files only when asked, since
+    // ordinary camera file names end in digits too
+    const bool numbered = sequenceCheckBox->isChecked();
+    ImageSequence first = ImageSequence::open(firstImagePath, numbered);
+    ImageSequence second = ImageSequence::open(secondImagePath, numbered);
+    if (first.isNull() || second.isNull() || (first.frameCount() < 2 && second.frameCount() < 2)) {
+        sequencePlayer->clear();
+        playbackBar->setVisible(false);
+        return;
+    }
+    
+    sequencePlayer->setSequences(first, second);
+    frameSlider->blockSignals(true);
+    frameSlider->setRange(0, sequencePlayer->frameCount() - 1);
+    frameSlider->setValue(sequencePlayer->currentFrame());
+    frameSlider->blockSignals(false);
+    frameLabel->setText(QString("%1 / %2").arg(sequencePlayer->currentFrame() + 1).arg(sequencePlayer->frameCount()));
+    playbackBar->setVisible(true);
+}
+
+void MainWindow::onPlayToggle()
+{
+    if (sequencePlayer->isPlaying()) {
+        sequencePlayer->pause();
+    } else {
+        sequencePlayer->play();
+    }
+}
+
+void MainWindow::onPlayingChanged(bool playing)
+{
+    playButton->setText(playing ? "Pause" : "Play");
+}
+
+void MainWindow::updateMemoryStatus()
+{
+    // Storage format and size per image, so compact storage is visible
+    QStringList parts;
+    const char *sides[2] = {"First", "Second"};
+    for (int side = 0; side < 2; ++side) {
+        const qint64 bytes = compareWidget->imageBytes(side);
+        if (bytes > 0) {
+            parts << QString("%1: %2 (%3)").arg(sides[side], locale().formattedDataSize(bytes),
+                                                formatName(compareWidget->imageFormat(side)));
+        }
+    }
+    if (parts.isEmpty()) {
+        statusBar()->clearMessage();
+        return;
+    }
+    statusBar()->showMessage(parts.join("  |  "));
+}
+
+void MainWindow::onSequenceFrame(int frame, const QImage &first, const QImage &second)
+{
+    // The change map is only worth building for a frame that stays on screen
+    compareWidget->setFrames(first, second, !sequencePlayer->isPlaying());
+    
+    frameSlider->blockSignals(true);
+    frameSlider->setValue(frame);
+    frameSlider->blockSignals(false);
+    frameLabel->setText(QString("%1 / %2").arg(frame + 1).arg(sequencePlayer->frameCount()));
 }
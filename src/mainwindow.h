@@ -16,7 +16,13 @@
 #include <QGroupBox>
 #include <QCheckBox>
 #include <QComboBox>
+#include <QSlider>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
 #include "imagecomparewidget.h"
+#include "imagematcher.h"
+#include "sequenceplayer.h"
+#include "pairstrip.h"
 
 class MainWindow : public QMainWindow
 {
@@ -29,18 +35,39 @@ public:
     // Public methods for loading images from command line
     void loadFirstImage(const QString &imagePath);
     void loadSecondImage(const QString &imagePath);
+    void loadPair(const QString &firstPath, const QString &secondPath);
+    void matchFolders(const QString &firstDir, const QString &secondDir);
+    void setLaunchTimer(const QElapsedTimer &timer);
+    void showStreamFrame(int side, const QImage &image);
+    
+    // Scripting entry point shared by the command line and the instance
+    // server. Returns an error message, or an empty string on success.
+    QString executeCommand(const QStringList &arguments);
 
 private slots:
     void selectFirstImage();
     void selectSecondImage();
     void onDirectionChanged();
-    void onCompareModeChanged();
+    void onCompareModeChanged(bool checked);
     void onDissolveSettingsChanged();
     void onDissolveToggle();
+    void onDifferenceSettingsChanged();
+    void selectFolders();
+    void onMatchFinished();
+    void onPairSelected(int index);
+    void exportDeepZoom();
+    void onExportFinished();
+    void onPlayToggle();
+    void onSequenceFrame(int frame, const QImage &first, const QImage &second);
+    void onPlayingChanged(bool playing);
+    void updateMemoryStatus();
 
 private:
     void setupUI();
     void updateCompareWidget();
+    void applyDirection();
+    void setImageLabel(QLabel *label, const QString &imagePath);
+    void setupSequences();
 
     // UI Components
     QWidget *centralWidget;
@@ -54,6 +81,19 @@ private:
     QLabel *firstImageLabel;
     QLabel *secondImageLabel;
     
+    // Folder matching controls
+    QPushButton *matchFoldersButton;
+    QCheckBox *sequenceCheckBox;
+    QFutureWatcher<QList<ImagePair>> *matchWatcher;
+    
+    // Filmstrip of matched pairs, shown once a match finds any
+    PairStrip *pairStrip;
+    PairStripModel *pairModel;
+    
+    // Deep zoom export, run off the GUI thread
+    QPushButton *exportButton;
+    QFutureWatcher<QString> *exportWatcher;
+    
     // Right side - Mode controls
     QVBoxLayout *modeControlsLayout;
     
@@ -71,13 +111,33 @@ private:
     QDoubleSpinBox *transitionTimeSpinBox;
     QPushButton *dissolveToggleButton;
     
+    // Difference mode controls
+    QHBoxLayout *differenceLayout;
+    QRadioButton *differenceModeRadio;
+    QLabel *toleranceLabel;
+    QDoubleSpinBox *toleranceSpinBox;
+    QCheckBox *antiAliasingCheckBox;
+    
+    // Flip mode controls
+    QHBoxLayout *flipLayout;
+    QRadioButton *flipModeRadio;
+    
     QButtonGroup *modeGroup;
     
+    // Sequence playback controls, shown when either side has several frames
+    QWidget *playbackBar;
+    QPushButton *playButton;
+    QSlider *frameSlider;
+    QLabel *frameLabel;
+    QDoubleSpinBox *fpsSpinBox;
+    SequencePlayer *sequencePlayer;
+    
     ImageCompareWidget *compareWidget;
     
     // Data
     QString firstImagePath;
     QString secondImagePath;
+    QList<ImagePair> pairs;
     bool isDissolving;
 };
 
@@ -0,0 +1,147 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#include "pairstrip.h"
+#include <QPainter>
+#include <QScrollBar>
+#include <QStyledItemDelegate>
+
+namespace {
+
+const int MARGIN = 4;
+
+class PairStripDelegate : public QStyledItemDelegate
+{
+public:
+    explicit PairStripDelegate(QObject *parent)
+        : QStyledItemDelegate(parent)
+    {
+    }
+
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &) const override
+    {
+        return QSize(2 * PairStripModel::THUMBNAIL_WIDTH + 3 * MARGIN,
+                     PairStripModel::THUMBNAIL_HEIGHT + option.fontMetrics.height() + 3 * MARGIN);
+    }
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override
+    {
+        painter->save();
+        if (option.state & QStyle::State_Selected) {
+            painter->fillRect(option.rect, option.palette.highlight());
+        }
+
+        // Thumbnails centred in fixed cells, a placeholder while loading
+        const QRect firstCell(option.rect.left() + MARGIN, option.rect.top() + MARGIN,
+                              PairStripModel::THUMBNAIL_WIDTH, PairStripModel::THUMBNAIL_HEIGHT);
+        const QRect secondCell = firstCell.translated(PairStripModel::THUMBNAIL_WIDTH + MARGIN, 0);
+        drawThumbnail(painter, option, firstCell, index.data(PairStripModel::FirstThumbnailRole).value<QImage>());
+        drawThumbnail(painter, option, secondCell, index.data(PairStripModel::SecondThumbnailRole).value<QImage>());
+
+        // Pair name under the thumbnails
+        const QRect textRect(option.rect.left() + MARGIN, firstCell.bottom() + MARGIN,
+                             option.rect.width() - 2 * MARGIN, option.fontMetrics.height());
+        painter->setPen(option.palette.color(option.state & QStyle::State_Selected
+                                             ? QPalette::HighlightedText : QPalette::Text));
+        painter->drawText(textRect, Qt::AlignCenter,
+                          option.fontMetrics.elidedText(index.data().toString(), Qt::ElideMiddle, textRect.width()));
+
+        // Badge: share of thumbnail pixels that differ perceptually
+        const double fraction = index.data(PairStripModel::ChangedFractionRole).toDouble();
+        if (fraction >= 0.0) {
+            QString badge;
+            QColor color;
+            if (fraction == 0.0) {
+                badge = "same";
+                color = QColor(40, 140, 60);
+            } else {
+                badge = QString("%1%").arg(fraction * 100.0, 0, 'f', fraction < 0.01 ? 2 : 1);
+                color = fraction < 0.01 ? QColor(200, 140, 0) : QColor(200, 40, 40);
+            }
+            const int badgeWidth = option.fontMetrics.horizontalAdvance(badge) + 2 * MARGIN;
+            const QRect badgeRect(secondCell.right() - badgeWidth, secondCell.top(),
+                                  badgeWidth, option.fontMetrics.height());
+            painter->setPen(Qt::NoPen);
+            painter->setBrush(color);
+            painter->setRenderHint(QPainter::Antialiasing);
+            painter->drawRoundedRect(badgeRect, 3, 3);
+            painter->setPen(Qt::white);
+            painter->drawText(badgeRect, Qt::AlignCenter, badge);
+        }
+        painter->restore();
+    }
+
+private:
+    static void drawThumbnail(QPainter *painter, const QStyleOptionViewItem &option,
+                              const QRect &cell, const QImage &image)
+    {
+        if (image.isNull()) {
+            painter->fillRect(cell, option.palette.mid());
+            return;
+        }
+        // Thumbnails are made at cell size, so this is a plain blit
+        const QPoint position(cell.left() + (cell.width() - image.width()) / 2,
+                              cell.top() + (cell.height() - image.height()) / 2);
+        painter->drawImage(position, image);
+    }
+};
+
+} // namespace
+
+PairStrip::PairStrip(QWidget *parent)
+    : QListView(parent)
+    , pairModel(nullptr)
+{
+    setFlow(QListView::LeftToRight);
+    setWrapping(false);
+    setUniformItemSizes(true);
+    setSelectionMode(QAbstractItemView::SingleSelection);
+    setHorizontalScrollMode(QAbstractItemView::ScrollPerPixel);
+    setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    setItemDelegate(new PairStripDelegate(this));
+
+    // One row of items plus the scroll bar
+    const int itemHeight = PairStripModel::THUMBNAIL_HEIGHT + fontMetrics().height() + 3 * MARGIN;
+    setFixedHeight(itemHeight + horizontalScrollBar()->sizeHint().height() + 2 * frameWidth() + MARGIN);
+}
+
+void PairStrip::setPairModel(PairStripModel *model)
+{
+    pairModel = model;
+    setModel(model);
+    connect(model, &QAbstractItemModel::modelReset, this, &PairStrip::updateVisibleRange);
+}
+
+void PairStrip::currentChanged(const QModelIndex &current, const QModelIndex &previous)
+{
+    QListView::currentChanged(current, previous);
+    if (current.isValid()) {
+        emit pairSelected(current.row());
+    }
+}
+
+void PairStrip::scrollContentsBy(int dx, int dy)
+{
+    QListView::scrollContentsBy(dx, dy);
+    updateVisibleRange();
+}
+
+void PairStrip::resizeEvent(QResizeEvent *event)
+{
+    QListView::resizeEvent(event);
+    updateVisibleRange();
+}
+
+void PairStrip::updateVisibleRange()
+{
+    if (!pairModel || pairModel->rowCount() == 0) return;
+
+    const QRect area = viewport()->rect();
+    const QModelIndex first = indexAt(QPoint(area.left() + MARGIN, area.center().y()));
+    const QModelIndex last = indexAt(QPoint(area.right() - MARGIN, area.center().y()));
+    pairModel->setVisibleRange(first.isValid() ? first.row() : 0,
+                               last.isValid() ? last.row() : pairModel->rowCount() - 1);
+}
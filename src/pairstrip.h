@@ -0,0 +1,41 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#ifndef PAIRSTRIP_H
+#define PAIRSTRIP_H
+
+#include <QListView>
+#include "pairstripmodel.h"
+
+// Horizontal filmstrip of matched pairs: both thumbnails side by side with
+// a badge for how much of the pair differs. Items are painted by a delegate
+// rather than created as widgets, so only the visible handful cost anything
+// however long the batch is. The visible range is passed to the model on
+// every scroll so thumbnails load around it first.
+class PairStrip : public QListView
+{
+    Q_OBJECT
+
+public:
+    explicit PairStrip(QWidget *parent = nullptr);
+
+    void setPairModel(PairStripModel *model);
+
+signals:
+    void pairSelected(int row);
+
+protected:
+    void currentChanged(const QModelIndex &current, const QModelIndex &previous) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    void updateVisibleRange();
+
+    PairStripModel *pairModel;
+};
+
+#endif // PAIRSTRIP_H
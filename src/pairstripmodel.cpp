@@ -0,0 +1,183 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#include "pairstripmodel.h"
+#include "imageloader.h"
+#include "perceptualdiff.h"
+#include "resampler.h"
+#include <QFileInfo>
+#include <QThread>
+#include <limits>
+
+PairStripModel::PairStripModel(QObject *parent)
+    : QAbstractListModel(parent)
+    , generation(0)
+    , visibleFirst(0)
+    , visibleLast(0)
+{
+    thumbnails.setMaxCost(THUMBNAIL_CACHE_KB);
+
+    // A few decodes at a time is enough to keep up with scrolling without
+    // competing with full-resolution loads of the selected pair
+    loadPool.setMaxThreadCount(qMax(2, QThread::idealThreadCount() / 2));
+}
+
+PairStripModel::~PairStripModel()
+{
+    loadPool.clear();
+    loadPool.waitForDone();
+}
+
+void PairStripModel::setPairs(const QList<ImagePair> &newPairs)
+{
+    beginResetModel();
+    pairs = newPairs;
+    ++generation;
+    loadPool.clear();
+    thumbnails.clear();
+    queue.clear();
+    loading.clear();
+    visibleFirst = 0;
+    visibleLast = 0;
+    endResetModel();
+}
+
+int PairStripModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(pairs.size());
+}
+
+QVariant PairStripModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= pairs.size()) return QVariant();
+
+    const int row = index.row();
+    const ImagePair &pair = pairs.at(row);
+    switch (role) {
+        case Qt::DisplayRole:
+            return QString("%1 \u2194 %2").arg(QFileInfo(pair.firstPath).fileName(),
+                                       QFileInfo(pair.secondPath).fileName());
+        case Qt::ToolTipRole:
+            return QString("%1\n%2\nHash distance %3").arg(pair.firstPath, pair.secondPath).arg(pair.distance);
+        case DistanceRole:
+            return pair.distance;
+        case FirstThumbnailRole:
+        case SecondThumbnailRole:
+        case ChangedFractionRole: {
+            const Thumbnail *thumbnail = thumbnails.object(row);
+            if (!thumbnail) {
+                // Views only ask for rows they paint, so this is what keeps
+                // loading limited to what is on screen
+                const_cast<PairStripModel *>(this)->requestThumbnail(row);
+                return role == ChangedFractionRole ? QVariant(-1.0) : QVariant(QImage());
+            }
+            if (role == FirstThumbnailRole) return thumbnail->first;
+            if (role == SecondThumbnailRole) return thumbnail->second;
+            return thumbnail->changedFraction;
+        }
+        default:
+            return QVariant();
+    }
+}
+
+void PairStripModel::setVisibleRange(int first, int last)
+{
+    visibleFirst = first;
+    visibleLast = last;
+
+    // Rows scrolled well out of view are dropped; they are asked for again
+    // when they are painted
+    for (int i = static_cast<int>(queue.size()) - 1; i >= 0; --i) {
+        const int row = queue.at(i);
+        if (row < visibleFirst - QUEUE_MARGIN || row > visibleLast + QUEUE_MARGIN) {
+            queue.remove(i);
+        }
+    }
+    scheduleLoads();
+}
+
+void PairStripModel::requestThumbnail(int row)
+{
+    if (thumbnails.contains(row) || loading.contains(row) || queue.contains(row)) return;
+    queue.append(row);
+    scheduleLoads();
+}
+
+void PairStripModel::scheduleLoads()
+{
+    while (loading.size() < loadPool.maxThreadCount() && !queue.isEmpty()) {
+        // Nearest to the visible range first
+        int best = 0;
+        int bestDistance = std::numeric_limits<int>::max();
+        for (int i = 0; i < queue.size(); ++i) {
+            const int row = queue.at(i);
+            const int distance = row < visibleFirst ? visibleFirst - row
+                               : (row > visibleLast ? row - visibleLast : 0);
+            if (distance < bestDistance) {
+                best = i;
+                bestDistance = distance;
+            }
+        }
+        const int row = queue.takeAt(best);
+        loading.insert(row);
+
+        const ImagePair pair = pairs.at(row);
+        const int loadGeneration = generation;
+        loadPool.start([this, pair, row, loadGeneration]() {
+            const Thumbnail thumbnail = loadThumbnail(pair);
+            QMetaObject::invokeMethod(this, [this, loadGeneration, row, thumbnail]() {
+                onThumbnailLoaded(loadGeneration, row, thumbnail);
+            }, Qt::QueuedConnection);
+        });
+    }
+}
+
+void PairStripModel::onThumbnailLoaded(int loadGeneration, int row, const Thumbnail &thumbnail)
+{
+    if (loadGeneration != generation) return;
+
+    loading.remove(row);
+    const qint64 bytes = thumbnail.first.sizeInBytes() + thumbnail.second.sizeInBytes();
+    thumbnails.insert(row, new Thumbnail(thumbnail), static_cast<int>(bytes / 1024) + 1);
+    emit dataChanged(index(row), index(row));
+    scheduleLoads();
+}
+
+PairStripModel::Thumbnail PairStripModel::loadThumbnail(const ImagePair &pair)
+{
+    Thumbnail thumbnail;
+    thumbnail.first = loadSide(pair.firstPath);
+    thumbnail.second = loadSide(pair.secondPath);
+    thumbnail.changedFraction = -1.0;
+
+    // The badge is a cheap estimate from the thumbnails themselves
+    if (!thumbnail.first.isNull() && !thumbnail.second.isNull()) {
+        QImage second = thumbnail.second;
+        if (second.size() != thumbnail.first.size()) {
+            second = Resampler::scale(second, thumbnail.first.size());
+        }
+        const PerceptualDiff::Result result = PerceptualDiff::compare(thumbnail.first, second,
+                                                                      PerceptualDiff::Options());
+        const qint64 pixels = static_cast<qint64>(thumbnail.first.width()) * thumbnail.first.height();
+        thumbnail.changedFraction = static_cast<double>(result.differentPixels) / pixels;
+    }
+    return thumbnail;
+}
+
+QImage PairStripModel::loadSide(const QString &path)
+{
+    // The embedded EXIF thumbnail avoids decoding the image at all; failing
+    // that, formats that can decode at reduced size do
+    const int decodeSize = THUMBNAIL_WIDTH * 2;
+    QImage image = ImageLoader::loadEmbeddedPreview(path, decodeSize);
+    if (image.isNull()) {
+        image = ImageLoader::loadReduced(path, decodeSize);
+    }
+    if (image.isNull()) return QImage();
+
+    const QSize fitted = image.size().scaled(THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT, Qt::KeepAspectRatio);
+    return Resampler::scale(image, fitted.expandedTo(QSize(1, 1)));
+}
@@ -0,0 +1,78 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#ifndef PAIRSTRIPMODEL_H
+#define PAIRSTRIPMODEL_H
+
+#include <QAbstractListModel>
+#include <QImage>
+#include <QCache>
+#include <QSet>
+#include <QVector>
+#include <QThreadPool>
+#include "imagematcher.h"
+
+// Matched pairs for the filmstrip, with thumbnails made on demand.
+//
+// A thumbnail is requested the first time the view asks for a row, which
+// only happens for rows it paints. Requests queue up and are handed to a
+// small worker pool nearest-to-the-visible-range first; rows scrolled far out
+// of view are dropped from the queue and requested again if they come back.
+// Finished thumbnails live in a cache bounded by memory, so long batches do
+// not grow without limit.
+class PairStripModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        FirstThumbnailRole = Qt::UserRole + 1,  // QImage, null until loaded
+        SecondThumbnailRole,
+        ChangedFractionRole,                    // double 0-1 from the thumbnails, -1 until loaded
+        DistanceRole                            // perceptual hash distance
+    };
+
+    explicit PairStripModel(QObject *parent = nullptr);
+    ~PairStripModel();
+
+    void setPairs(const QList<ImagePair> &pairs);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    // Rows the view shows; loads are ordered by distance from this range
+    void setVisibleRange(int first, int last);
+
+    static const int THUMBNAIL_WIDTH = 96;
+    static const int THUMBNAIL_HEIGHT = 72;
+
+private:
+    struct Thumbnail {
+        QImage first;
+        QImage second;
+        double changedFraction;
+    };
+
+    void requestThumbnail(int row);
+    void scheduleLoads();
+    void onThumbnailLoaded(int generation, int row, const Thumbnail &thumbnail);
+    static Thumbnail loadThumbnail(const ImagePair &pair);
+    static QImage loadSide(const QString &path);
+
+    QList<ImagePair> pairs;
+    QCache<int, Thumbnail> thumbnails;  // cost in KB
+    QVector<int> queue;                 // rows waiting for a worker
+    QSet<int> loading;
+    QThreadPool loadPool;
+    int generation;      // bumped by setPairs so results for old pairs are dropped
+    int visibleFirst;
+    int visibleLast;
+
+    static const int THUMBNAIL_CACHE_KB = 64 * 1024;
+    static const int QUEUE_MARGIN = 50; // rows beyond the visible range kept queued
+};
+
+#endif // PAIRSTRIPMODEL_H
@@ -0,0 +1,250 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#include "perceptualdiff.h"
+#include <QVector>
+#include <QtConcurrent/QtConcurrentMap>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// Largest possible YIQ delta between two colors; the threshold scales it
+const float MAX_YIQ_DELTA = 35215.0f;
+
+// Read-only view of an ARGB32 image, cheap to copy into worker lambdas
+struct Plane {
+    const uchar *bits;
+    qsizetype stride;
+    int width;
+    int height;
+
+    QRgb pixel(int x, int y) const
+    {
+        return reinterpret_cast<const QRgb *>(bits + y * stride)[x];
+    }
+};
+
+Plane planeOf(const QImage &image)
+{
+    return {image.constBits(), image.bytesPerLine(), image.width(), image.height()};
+}
+
+// Translucent pixels are compared as if drawn over white
+inline void blendedChannels(QRgb pixel, float *r, float *g, float *b)
+{
+    *r = qRed(pixel);
+    *g = qGreen(pixel);
+    *b = qBlue(pixel);
+    const int alpha = qAlpha(pixel);
+    if (alpha < 255) {
+        const float a = alpha / 255.0f;
+        *r = 255.0f + (*r - 255.0f) * a;
+        *g = 255.0f + (*g - 255.0f) * a;
+        *b = 255.0f + (*b - 255.0f) * a;
+    }
+}
+
+inline float brightness(QRgb pixel)
+{
+    float r, g, b;
+    blendedChannels(pixel, &r, &g, &b);
+    return r * 0.29889531f + g * 0.58662247f + b * 0.11448223f;
+}
+
+// Weighted squared YIQ distance
+inline float colorDelta(QRgb first, QRgb second)
+{
+    if (first == second) return 0.0f;
+
+    float r1, g1, b1, r2, g2, b2;
+    blendedChannels(first, &r1, &g1, &b1);
+    blendedChannels(second, &r2, &g2, &b2);
+
+    const float y = (r1 - r2) * 0.29889531f + (g1 - g2) * 0.58662247f + (b1 - b2) * 0.11448223f;
+    const float i = (r1 - r2) * 0.59597799f - (g1 - g2) * 0.27417610f - (b1 - b2) * 0.32180189f;
+    const float q = (r1 - r2) * 0.21147017f - (g1 - g2) * 0.52261711f + (b1 - b2) * 0.31114694f;
+    return 0.5053f * y * y + 0.299f * i * i + 0.1957f * q * q;
+}
+
+// True when at least three of the pixel's neighbours have exactly its color;
+// pixels on the image border count the missing side as one
+bool hasManySiblings(const Plane &plane, int cx, int cy)
+{
+    const int x0 = qMax(cx - 1, 0);
+    const int y0 = qMax(cy - 1, 0);
+    const int x1 = qMin(cx + 1, plane.width - 1);
+    const int y1 = qMin(cy + 1, plane.height - 1);
+    const QRgb center = plane.pixel(cx, cy);
+
+    int zeroes = (cx == x0 || cx == x1 || cy == y0 || cy == y1) ? 1 : 0;
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            if (x == cx && y == cy) continue;
+            if (plane.pixel(x, y) == center && ++zeroes > 2) return true;
+        }
+    }
+    return false;
+}
+
+// A pixel is taken as anti-aliasing when it sits between a darker and a
+// brighter neighbour, has at most two neighbours of equal brightness, and the
+// darkest or brightest neighbour is part of a flat area in both images
+bool isAntiAliased(const Plane &plane, const Plane &other, int cx, int cy)
+{
+    const int x0 = qMax(cx - 1, 0);
+    const int y0 = qMax(cy - 1, 0);
+    const int x1 = qMin(cx + 1, plane.width - 1);
+    const int y1 = qMin(cy + 1, plane.height - 1);
+    const float center = brightness(plane.pixel(cx, cy));
+
+    int zeroes = (cx == x0 || cx == x1 || cy == y0 || cy == y1) ? 1 : 0;
+    float darkest = 0.0f;
+    float brightest = 0.0f;
+    int darkX = 0, darkY = 0, brightX = 0, brightY = 0;
+
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            if (x == cx && y == cy) continue;
+
+            const float delta = center - brightness(plane.pixel(x, y));
+            if (delta == 0.0f) {
+                if (++zeroes > 2) return false;
+            } else if (delta < darkest) {
+                darkest = delta;
+                darkX = x;
+                darkY = y;
+            } else if (delta > brightest) {
+                brightest = delta;
+                brightX = x;
+                brightY = y;
+            }
+        }
+    }
+
+    if (darkest == 0.0f || brightest == 0.0f) return false;
+
+    return (hasManySiblings(plane, darkX, darkY) && hasManySiblings(other, darkX, darkY))
+        || (hasManySiblings(plane, brightX, brightY) && hasManySiblings(other, brightX, brightY));
+}
+
+} // namespace
+
+PerceptualDiff::Options::Options()
+    : threshold(DEFAULT_THRESHOLD)
+    , includeAntiAliasing(false)
+{
+}
+
+PerceptualDiff::Result::Result()
+    : differentPixels(0)
+    , antiAliasedPixels(0)
+{
+}
+
+PerceptualDiff::Result PerceptualDiff::compare(const QImage &first, const QImage &second, const Options &options,
+                                               qint64 budget, QImage *diff)
+{
+    Result result;
+    if (first.isNull() || first.size() != second.size()) return result;
+
+    // No-ops for images that are already ARGB32
+    const QImage firstPixels = first.convertToFormat(QImage::Format_ARGB32);
+    const QImage secondPixels = second.convertToFormat(QImage::Format_ARGB32);
+    const Plane firstPlane = planeOf(firstPixels);
+    const Plane secondPlane = planeOf(secondPixels);
+    const int width = firstPlane.width;
+    const int height = firstPlane.height;
+
+    QRgb *diffBits = nullptr;
+    qsizetype diffStride = 0;
+    if (diff) {
+        *diff = QImage(firstPixels.size(), QImage::Format_RGB32);
+        diffBits = reinterpret_cast<QRgb *>(diff->bits());
+        diffStride = diff->bytesPerLine() / static_cast<qsizetype>(sizeof(QRgb));
+        budget = -1;
+    }
+    const qint64 limit = budget < 0 ? std::numeric_limits<qint64>::max() : budget;
+    const float maxDelta = MAX_YIQ_DELTA * static_cast<float>(options.threshold * options.threshold);
+
+    QVector<int> bands((height + BAND_HEIGHT - 1) / BAND_HEIGHT);
+    for (int i = 0; i < bands.size(); ++i) {
+        bands[i] = i;
+    }
+
+    // Bands share one running count; once it passes the budget the
+    // remaining bands return immediately
+    std::atomic<qint64> differences(0);
+    std::atomic<qint64> antiAliased(0);
+
+    QtConcurrent::blockingMap(bands, [&](int band) {
+        if (differences.load(std::memory_order_relaxed) > limit) return;
+
+        const int top = band * BAND_HEIGHT;
+        const int bottom = qMin(top + BAND_HEIGHT, height);
+
+        for (int y = top; y < bottom; ++y) {
+            const QRgb *a = reinterpret_cast<const QRgb *>(firstPlane.bits + y * firstPlane.stride);
+            const QRgb *b = reinterpret_cast<const QRgb *>(secondPlane.bits + y * secondPlane.stride);
+            QRgb *out = diffBits ? diffBits + y * diffStride : nullptr;
+
+            if (out) {
+                for (int x = 0; x < width; ++x) {
+                    const int gray = 192 + qGray(a[x]) / 4;
+                    out[x] = qRgb(gray, gray, gray);
+                }
+            }
+            if (std::memcmp(a, b, static_cast<size_t>(width) * sizeof(QRgb)) == 0) continue;
+
+            qint64 rowDifferences = 0;
+            qint64 rowAntiAliased = 0;
+            int x = 0;
+            while (x < width) {
+                // Runs of identical pixels are skipped eight at a time; the
+                // branch-free inner loop is vectorized by the compiler
+                if (x + 8 <= width) {
+                    quint32 changed = 0;
+                    for (int i = 0; i < 8; ++i) {
+                        changed |= a[x + i] ^ b[x + i];
+                    }
+                    if (changed == 0) {
+                        x += 8;
+                        continue;
+                    }
+                }
+
+                const int end = qMin(x + 8, width);
+                for (; x < end; ++x) {
+                    if (colorDelta(a[x], b[x]) <= maxDelta) continue;
+
+                    if (!options.includeAntiAliasing
+                        && (isAntiAliased(firstPlane, secondPlane, x, y)
+                            || isAntiAliased(secondPlane, firstPlane, x, y))) {
+                        ++rowAntiAliased;
+                        if (out) out[x] = qRgb(255, 255, 0);
+                    } else {
+                        ++rowDifferences;
+                        if (out) out[x] = qRgb(255, 0, 0);
+                    }
+                }
+            }
+
+            if (rowAntiAliased > 0) {
+                antiAliased.fetch_add(rowAntiAliased, std::memory_order_relaxed);
+            }
+            if (rowDifferences > 0
+                && differences.fetch_add(rowDifferences, std::memory_order_relaxed) + rowDifferences > limit) {
+                return;
+            }
+        }
+    });
+
+    result.differentPixels = differences.load();
+    result.antiAliasedPixels = antiAliased.load();
+    return result;
+}
@@ -0,0 +1,48 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#ifndef PERCEPTUALDIFF_H
+#define PERCEPTUALDIFF_H
+
+#include <QImage>
+
+// Perceptual pixel difference in the style of pixelmatch.
+//
+// Colors are compared by their distance in YIQ space rather than per channel,
+// and a differing pixel whose neighbourhood looks like an anti-aliased edge in
+// both images is reported separately instead of as a difference. Work is
+// split into row bands that run on the global thread pool.
+class PerceptualDiff
+{
+public:
+    struct Options {
+        Options();
+
+        double threshold;          // 0-1, larger tolerates bigger color changes
+        bool includeAntiAliasing;  // count anti-aliased pixels as differences too
+    };
+
+    struct Result {
+        Result();
+
+        qint64 differentPixels;
+        qint64 antiAliasedPixels;
+    };
+
+    // Compares two images of the same size. Counting stops early once more
+    // than budget pixels differ; a negative budget compares everything. When
+    // diff is given the whole image is compared and diff receives differences
+    // in red and ignored anti-aliasing in yellow over a faded copy of first.
+    static Result compare(const QImage &first, const QImage &second, const Options &options,
+                          qint64 budget = -1, QImage *diff = nullptr);
+
+    static constexpr double DEFAULT_THRESHOLD = 0.1;
+
+private:
+    static const int BAND_HEIGHT = 64;
+};
+
+#endif // PERCEPTUALDIFF_H
@@ -0,0 +1,175 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#include "perceptualhash.h"
+#include "imageloader.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtMath>
+#include <algorithm>
+
+namespace {
+
+const int SAMPLE_SIZE = 32; // image is reduced to SAMPLE_SIZE^2 before the DCT
+const int HASH_SIZE = 8;    // low-frequency HASH_SIZE^2 block forms the hash
+
+const quint32 CACHE_MAGIC = 0x50484331; // "PHC1"
+const quint32 CACHE_VERSION = 1;
+
+} // namespace
+
+quint64 PerceptualHash::compute(const QImage &image)
+{
+    if (image.isNull()) return 0;
+
+    QImage sample = image.scaled(SAMPLE_SIZE, SAMPLE_SIZE, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                         .convertToFormat(QImage::Format_Grayscale8);
+
+    double pixels[SAMPLE_SIZE][SAMPLE_SIZE];
+    for (int y = 0; y < SAMPLE_SIZE; ++y) {
+        const uchar *line = sample.constScanLine(y);
+        for (int x = 0; x < SAMPLE_SIZE; ++x) {
+            pixels[y][x] = line[x];
+        }
+    }
+
+    // Separable DCT-II, only the low-frequency rows/columns are needed
+    double cosines[HASH_SIZE][SAMPLE_SIZE];
+    for (int u = 0; u < HASH_SIZE; ++u) {
+        for (int x = 0; x < SAMPLE_SIZE; ++x) {
+            cosines[u][x] = qCos((2 * x + 1) * u * M_PI / (2.0 * SAMPLE_SIZE));
+        }
+    }
+
+    double rows[SAMPLE_SIZE][HASH_SIZE];
+    for (int y = 0; y < SAMPLE_SIZE; ++y) {
+        for (int u = 0; u < HASH_SIZE; ++u) {
+            double sum = 0.0;
+            for (int x = 0; x < SAMPLE_SIZE; ++x) {
+                sum += pixels[y][x] * cosines[u][x];
+            }
+            rows[y][u] = sum;
+        }
+    }
+
+    double coefficients[HASH_SIZE * HASH_SIZE];
+    for (int v = 0; v < HASH_SIZE; ++v) {
+        for (int u = 0; u < HASH_SIZE; ++u) {
+            double sum = 0.0;
+            for (int y = 0; y < SAMPLE_SIZE; ++y) {
+                sum += rows[y][u] * cosines[v][y];
+            }
+            coefficients[v * HASH_SIZE + u] = sum;
+        }
+    }
+
+    // Threshold against the median, leaving out the DC term which only
+    // tracks overall brightness
+    double sorted[HASH_SIZE * HASH_SIZE - 1];
+    std::copy(coefficients + 1, coefficients + HASH_SIZE * HASH_SIZE, sorted);
+    std::nth_element(sorted, sorted + (HASH_SIZE * HASH_SIZE - 1) / 2, sorted + HASH_SIZE * HASH_SIZE - 1);
+    double median = sorted[(HASH_SIZE * HASH_SIZE - 1) / 2];
+
+    quint64 hash = 0;
+    for (int i = 0; i < HASH_SIZE * HASH_SIZE; ++i) {
+        if (coefficients[i] > median) {
+            hash |= (Q_UINT64_C(1) << i);
+        }
+    }
+    return hash;
+}
+
+bool PerceptualHash::computeFile(const QString &path, quint64 *hash)
+{
+    QImage image = ImageLoader::loadReduced(path, DECODE_SIZE);
+    if (image.isNull()) return false;
+
+    *hash = compute(image);
+    return true;
+}
+
+int PerceptualHash::distance(quint64 a, quint64 b)
+{
+    return static_cast<int>(qPopulationCount(a ^ b));
+}
+
+PerceptualHashCache::PerceptualHashCache()
+{
+}
+
+QString PerceptualHashCache::cacheFilePath() const
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/perceptual-hashes.bin";
+}
+
+bool PerceptualHashCache::load()
+{
+    QFile file(cacheFilePath());
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream stream(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION) return false;
+
+    quint32 count = 0;
+    stream >> count;
+    entries.clear();
+    entries.reserve(count);
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString path;
+        Entry entry;
+        stream >> path >> entry.size >> entry.modified >> entry.hash;
+        entries.insert(path, entry);
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+bool PerceptualHashCache::save() const
+{
+    QDir().mkpath(QFileInfo(cacheFilePath()).absolutePath());
+
+    // Write to a temporary file and rename so concurrent readers never see
+    // a partially written cache
+    QSaveFile file(cacheFilePath());
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream stream(&file);
+    stream << CACHE_MAGIC << CACHE_VERSION << static_cast<quint32>(entries.size());
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        stream << it.key() << it->size << it->modified << it->hash;
+    }
+    return file.commit();
+}
+
+bool PerceptualHashCache::lookup(const QString &path, quint64 *hash) const
+{
+    auto it = entries.constFind(path);
+    if (it == entries.constEnd()) return false;
+
+    QFileInfo info(path);
+    if (info.size() != it->size || info.lastModified().toMSecsSinceEpoch() != it->modified) {
+        return false;
+    }
+    *hash = it->hash;
+    return true;
+}
+
+void PerceptualHashCache::insert(const QString &path, quint64 hash)
+{
+    QFileInfo info(path);
+    Entry entry;
+    entry.size = info.size();
+    entry.modified = info.lastModified().toMSecsSinceEpoch();
+    entry.hash = hash;
+    entries.insert(path, entry);
+}
@@ -0,0 +1,50 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#ifndef PERCEPTUALHASH_H
+#define PERCEPTUALHASH_H
+
+#include <QHash>
+#include <QImage>
+#include <QString>
+
+// 64-bit DCT perceptual hash. Visually similar images hash to values with a
+// small Hamming distance, regardless of file name, size or encoding.
+class PerceptualHash
+{
+public:
+    static quint64 compute(const QImage &image);
+    static bool computeFile(const QString &path, quint64 *hash);
+    static int distance(quint64 a, quint64 b);
+
+    static const int DECODE_SIZE = 256; // longest side decoded for hashing
+};
+
+// On-disk hash cache keyed by absolute path, invalidated by size and mtime.
+class PerceptualHashCache
+{
+public:
+    PerceptualHashCache();
+
+    bool load();
+    bool save() const;
+
+    bool lookup(const QString &path, quint64 *hash) const;
+    void insert(const QString &path, quint64 hash);
+
+private:
+    struct Entry {
+        qint64 size;
+        qint64 modified; // msecs since epoch
+        quint64 hash;
+    };
+
+    QString cacheFilePath() const;
+
+    QHash<QString, Entry> entries;
+};
+
+#endif // PERCEPTUALHASH_H
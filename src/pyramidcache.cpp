@@ -0,0 +1,193 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#include "pyramidcache.h"
+#include "imageloader.h"
+#include "resampler.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+
+namespace {
+
+const quint32 PYRAMID_MAGIC = 0x50595231; // "PYR1", also catches foreign byte order
+const quint32 PYRAMID_VERSION = 1;
+const quint32 MAX_LEVELS = 16;
+const qint64 DATA_ALIGNMENT = 64;
+
+struct FileHeader {
+    quint32 magic;
+    quint32 version;
+    quint32 levelCount;
+    quint32 reserved;
+};
+
+struct LevelHeader {
+    quint32 width;
+    quint32 height;
+    quint32 bytesPerLine;
+    quint32 format; // QImage::Format
+    quint64 offset; // from start of file, DATA_ALIGNMENT aligned
+};
+
+qint64 alignUp(qint64 value)
+{
+    return (value + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+}
+
+void releaseMappedFile(void *info)
+{
+    // Closing the QFile also unmaps the level the image pointed into
+    delete static_cast<QFile *>(info);
+}
+
+} // namespace
+
+QString PyramidCache::cacheDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/pyramids";
+}
+
+QString PyramidCache::entryPath(const QString &path)
+{
+    QFileInfo info(path);
+    QByteArray identity = info.absoluteFilePath().toUtf8()
+        + '\n' + QByteArray::number(info.size())
+        + '\n' + QByteArray::number(info.lastModified().toMSecsSinceEpoch());
+    QByteArray key = QCryptographicHash::hash(identity, QCryptographicHash::Sha1).toHex();
+    return cacheDirectory() + "/" + QString::fromLatin1(key) + ".pyr";
+}
+
+QImage PyramidCache::lookup(const QString &path, const QSize &targetSize)
+{
+    QFile *file = new QFile(entryPath(path));
+    if (!file->open(QIODevice::ReadOnly) || file->size() < static_cast<qint64>(sizeof(FileHeader))) {
+        delete file;
+        return QImage();
+    }
+
+    const qint64 fileSize = file->size();
+    uchar *data = file->map(0, fileSize);
+    if (!data) {
+        delete file;
+        return QImage();
+    }
+
+    const FileHeader *header = reinterpret_cast<const FileHeader *>(data);
+    const qint64 tableEnd = sizeof(FileHeader) + static_cast<qint64>(header->levelCount) * sizeof(LevelHeader);
+    if (header->magic != PYRAMID_MAGIC || header->version != PYRAMID_VERSION
+        || header->levelCount == 0 || header->levelCount > MAX_LEVELS || tableEnd > fileSize) {
+        delete file;
+        return QImage();
+    }
+
+    // Levels are stored largest first; walk down while the next one still covers the target
+    const LevelHeader *levels = reinterpret_cast<const LevelHeader *>(data + sizeof(FileHeader));
+    quint32 chosen = 0;
+    for (quint32 i = 1; i < header->levelCount; ++i) {
+        bool covers = static_cast<int>(levels[i].width) >= targetSize.width()
+                   || static_cast<int>(levels[i].height) >= targetSize.height();
+        if (!covers) break;
+        chosen = i;
+    }
+
+    const LevelHeader &level = levels[chosen];
+    if (level.offset + static_cast<quint64>(level.bytesPerLine) * level.height > static_cast<quint64>(fileSize)) {
+        delete file;
+        return QImage();
+    }
+
+    // Mark the entry as recently used for LRU eviction
+    file->setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+
+    // Read-only view of the mapping; any write access detaches into a private copy
+    const uchar *pixels = data + level.offset;
+    return QImage(pixels, static_cast<int>(level.width), static_cast<int>(level.height), level.bytesPerLine,
+                  static_cast<QImage::Format>(level.format), releaseMappedFile, file);
+}
+
+bool PyramidCache::store(const QString &path, const QImage &fullImage)
+{
+    if (fullImage.isNull()) return false;
+
+    // Top level is capped at MAX_LEVEL_DIMENSION, each further level halves it
+    QVector<QImage> levels;
+    QSize topSize = fullImage.size() / 2;
+    if (qMax(fullImage.width(), fullImage.height()) > MAX_LEVEL_DIMENSION * 2) {
+        topSize = fullImage.size().scaled(MAX_LEVEL_DIMENSION, MAX_LEVEL_DIMENSION, Qt::KeepAspectRatio);
+    }
+    if (qMax(topSize.width(), topSize.height()) < MIN_LEVEL_DIMENSION) return false;
+
+    // Levels are stored compact, each in its own format, and mapped back as is
+    QImage level = Resampler::scale(fullImage, topSize);
+    while (!level.isNull() && qMax(level.width(), level.height()) >= MIN_LEVEL_DIMENSION
+           && levels.size() < static_cast<int>(MAX_LEVELS)) {
+        levels.append(ImageLoader::compact(level));
+        level = Resampler::scale(level, level.size() / 2);
+    }
+
+    if (!QDir().mkpath(cacheDirectory())) return false;
+
+    FileHeader header;
+    header.magic = PYRAMID_MAGIC;
+    header.version = PYRAMID_VERSION;
+    header.levelCount = static_cast<quint32>(levels.size());
+    header.reserved = 0;
+
+    QVector<LevelHeader> table(levels.size());
+    qint64 offset = alignUp(sizeof(FileHeader) + levels.size() * sizeof(LevelHeader));
+    for (int i = 0; i < levels.size(); ++i) {
+        table[i].width = static_cast<quint32>(levels.at(i).width());
+        table[i].height = static_cast<quint32>(levels.at(i).height());
+        table[i].bytesPerLine = static_cast<quint32>(levels.at(i).bytesPerLine());
+        table[i].format = static_cast<quint32>(levels.at(i).format());
+        table[i].offset = static_cast<quint64>(offset);
+        offset = alignUp(offset + levels.at(i).sizeInBytes());
+    }
+
+    // QSaveFile renames into place on commit, so another instance either maps
+    // the previous complete file or the new complete file, never a partial one
+    QSaveFile file(entryPath(path));
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(table.constData()), table.size() * sizeof(LevelHeader));
+    for (int i = 0; i < levels.size(); ++i) {
+        QByteArray padding(static_cast<int>(table.at(i).offset - file.pos()), '\0');
+        file.write(padding);
+        file.write(reinterpret_cast<const char *>(levels.at(i).constBits()), levels.at(i).sizeInBytes());
+    }
+    if (!file.commit()) return false;
+
+    enforceLimit();
+    return true;
+}
+
+void PyramidCache::enforceLimit()
+{
+    QDir directory(cacheDirectory());
+
+    // Only one instance prunes at a time; others just skip this round
+    QLockFile lock(directory.filePath(".prune.lock"));
+    if (!lock.tryLock(0)) return;
+
+    // Newest first, so everything past the budget is least recently used
+    const QFileInfoList entries = directory.entryInfoList(QStringList() << "*.pyr", QDir::Files, QDir::Time);
+    qint64 total = 0;
+    for (const QFileInfo &entry : entries) {
+        total += entry.size();
+        if (total > MAX_CACHE_BYTES) {
+            // Instances that still map the file keep their pages until they unmap
+            QFile::remove(entry.absoluteFilePath());
+        }
+    }
+}
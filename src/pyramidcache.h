@@ -0,0 +1,40 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#ifndef PYRAMIDCACHE_H
+#define PYRAMIDCACHE_H
+
+#include <QImage>
+#include <QSize>
+#include <QString>
+
+// Persistent cache of downscaled pyramid levels, one file per source image
+// under the user cache directory. Files hold raw pixel rows so a level can be
+// memory-mapped and displayed without decoding. Entries are keyed by path,
+// file size and mtime, written atomically, and evicted least recently used
+// first once the cache grows past MAX_CACHE_BYTES.
+class PyramidCache
+{
+public:
+    // Smallest cached level that covers targetSize when fitted, or the
+    // largest level if none does. Returns a null image on a cache miss.
+    static QImage lookup(const QString &path, const QSize &targetSize);
+
+    // Build and store the pyramid for a freshly decoded full-size image
+    static bool store(const QString &path, const QImage &fullImage);
+
+    static QString cacheDirectory();
+
+    static const int MAX_LEVEL_DIMENSION = 4096; // largest level stored
+    static const int MIN_LEVEL_DIMENSION = 256;  // pyramid stops below this
+    static constexpr qint64 MAX_CACHE_BYTES = Q_INT64_C(2) * 1024 * 1024 * 1024;
+
+private:
+    static QString entryPath(const QString &path);
+    static void enforceLimit();
+};
+
+#endif // PYRAMIDCACHE_H
@@ -0,0 +1,263 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#include "regressioncheck.h"
+#include "imageloader.h"
+#include "perceptualdiff.h"
+#include "diffmap.h"
+#include "diffsidecar.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QFuture>
+#include <QImageReader>
+#include <QVector>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+const qint64 COMPARE_CHUNK_BYTES = 4 * 1024 * 1024;
+
+// True when any channel of the two ARGB32 pixels differs by more than threshold
+inline bool pixelDiffers(QRgb a, QRgb b, int threshold)
+{
+    if (a == b) return false;
+    return std::abs(qRed(a) - qRed(b)) > threshold
+        || std::abs(qGreen(a) - qGreen(b)) > threshold
+        || std::abs(qBlue(a) - qBlue(b)) > threshold
+        || std::abs(qAlpha(a) - qAlpha(b)) > threshold;
+}
+
+} // namespace
+
+RegressionCheck::Options::Options()
+    : threshold(0)
+    , perceptualThreshold(-1.0)
+    , includeAntiAliasing(false)
+    , maxDifferentPixels(0)
+    , maxDifferentRatio(-1.0)
+    , writeSidecar(false)
+{
+}
+
+RegressionCheck::ExitCode RegressionCheck::run(const QString &firstPath, const QString &secondPath,
+                                               const Options &options, QString *message)
+{
+    // Fast path: identical bytes cannot produce different pixels
+    if (filesIdentical(firstPath, secondPath)) {
+        *message = "PASS: files are byte-identical";
+        if (options.writeSidecar) {
+            *message += writeSidecar(firstPath, secondPath, unchangedMap(firstPath), options, 0, 0);
+        }
+        return Pass;
+    }
+
+    // Decode both images concurrently
+    QFuture<QImage> firstFuture = QtConcurrent::run([firstPath]() { return ImageLoader::load(firstPath); });
+    QImage second = ImageLoader::load(secondPath);
+    QImage first = firstFuture.result();
+
+    if (first.isNull() || second.isNull()) {
+        *message = QString("ERROR: cannot read %1").arg(first.isNull() ? firstPath : secondPath);
+        return Error;
+    }
+    if (first.size() != second.size()) {
+        *message = QString("FAIL: size mismatch (%1x%2 vs %3x%4)")
+            .arg(first.width()).arg(first.height()).arg(second.width()).arg(second.height());
+        if (options.writeSidecar) {
+            *message += ", no diff map written for images of different sizes";
+        }
+        return Fail;
+    }
+
+    first = first.convertToFormat(QImage::Format_ARGB32);
+    second = second.convertToFormat(QImage::Format_ARGB32);
+
+    const qint64 totalPixels = static_cast<qint64>(first.width()) * first.height();
+    qint64 budget = options.maxDifferentPixels;
+    if (options.maxDifferentRatio >= 0.0) {
+        budget = static_cast<qint64>(options.maxDifferentRatio * totalPixels);
+    }
+
+    const bool perceptual = options.perceptualThreshold >= 0.0;
+    PerceptualDiff::Options perceptualOptions;
+    perceptualOptions.threshold = options.perceptualThreshold;
+    perceptualOptions.includeAntiAliasing = options.includeAntiAliasing;
+
+    qint64 differences = 0;
+    qint64 antiAliased = 0;
+    QString antiAliasNote;
+    if (perceptual) {
+        PerceptualDiff::Result result = PerceptualDiff::compare(first, second, perceptualOptions, budget);
+        differences = result.differentPixels;
+        antiAliased = result.antiAliasedPixels;
+        if (result.antiAliasedPixels > 0) {
+            antiAliasNote = QString(", %1 anti-aliased ignored").arg(result.antiAliasedPixels);
+        }
+    } else {
+        differences = countDifferences(first, second, options.threshold, budget);
+    }
+    if (differences <= budget) {
+        *message = QString("PASS: %1 of %2 pixels differ (budget %3)%4")
+            .arg(differences).arg(totalPixels).arg(budget).arg(antiAliasNote);
+        if (options.writeSidecar) {
+            *message += writeSidecar(firstPath, secondPath, DiffMap::compute(first, second),
+                                     options, differences, antiAliased);
+        }
+        return Pass;
+    }
+
+    // Failure: only now pay for a full diff image
+    QString diffPath = options.diffOutputPath;
+    if (diffPath.isEmpty()) {
+        QFileInfo secondInfo(secondPath);
+        diffPath = secondInfo.path() + "/" + secondInfo.completeBaseName() + "-diff.png";
+    }
+    QImage diff;
+    if (perceptual) {
+        // The full pass also gives the exact counts the early stop cut short
+        PerceptualDiff::Result result = PerceptualDiff::compare(first, second, perceptualOptions, -1, &diff);
+        differences = result.differentPixels;
+        antiAliased = result.antiAliasedPixels;
+    } else {
+        diff = diffImage(first, second, options.threshold);
+    }
+    bool written = diff.save(diffPath);
+
+    *message = QString("FAIL: %1%2 pixels differ (budget %3)%4")
+        .arg(perceptual ? "" : "more than ").arg(differences).arg(budget)
+        .arg(written ? QString(", diff written to %1").arg(diffPath)
+                     : QString(", could not write diff to %1").arg(diffPath));
+    if (options.writeSidecar) {
+        *message += writeSidecar(firstPath, secondPath, DiffMap::compute(first, second),
+                                 options, differences, antiAliased);
+    }
+    return Fail;
+}
+
+bool RegressionCheck::filesIdentical(const QString &firstPath, const QString &secondPath)
+{
+    QFile firstFile(firstPath);
+    QFile secondFile(secondPath);
+    if (!firstFile.open(QIODevice::ReadOnly) || !secondFile.open(QIODevice::ReadOnly)) return false;
+    if (firstFile.size() != secondFile.size()) return false;
+
+    const qint64 size = firstFile.size();
+    if (size == 0) return true;
+
+    uchar *firstData = firstFile.map(0, size);
+    uchar *secondData = secondFile.map(0, size);
+    if (!firstData || !secondData) return false;
+
+    // Compare in chunks so a mismatch near the start stops early
+    for (qint64 offset = 0; offset < size; offset += COMPARE_CHUNK_BYTES) {
+        const size_t length = static_cast<size_t>(qMin(COMPARE_CHUNK_BYTES, size - offset));
+        if (std::memcmp(firstData + offset, secondData + offset, length) != 0) return false;
+    }
+    return true;
+}
+
+qint64 RegressionCheck::countDifferences(const QImage &first, const QImage &second, int threshold, qint64 budget)
+{
+    const int columns = (first.width() + TILE_SIZE - 1) / TILE_SIZE;
+    const int rows = (first.height() + TILE_SIZE - 1) / TILE_SIZE;
+    QVector<int> tiles(columns * rows);
+    for (int i = 0; i < tiles.size(); ++i) {
+        tiles[i] = i;
+    }
+
+    // Tiles share one running count; once it passes the budget the
+    // remaining tiles return immediately
+    std::atomic<qint64> differences(0);
+
+    QtConcurrent::blockingMap(tiles, [&](int tile) {
+        if (differences.load(std::memory_order_relaxed) > budget) return;
+
+        const int left = (tile % columns) * TILE_SIZE;
+        const int top = (tile / columns) * TILE_SIZE;
+        const int right = qMin(left + TILE_SIZE, first.width());
+        const int bottom = qMin(top + TILE_SIZE, first.height());
+
+        for (int y = top; y < bottom; ++y) {
+            const QRgb *a = reinterpret_cast<const QRgb *>(first.constScanLine(y));
+            const QRgb *b = reinterpret_cast<const QRgb *>(second.constScanLine(y));
+            qint64 rowDifferences = 0;
+            for (int x = left; x < right; ++x) {
+                rowDifferences += pixelDiffers(a[x], b[x], threshold);
+            }
+            if (rowDifferences > 0
+                && differences.fetch_add(rowDifferences, std::memory_order_relaxed) + rowDifferences > budget) {
+                return;
+            }
+        }
+    });
+
+    return differences.load();
+}
+
+DiffMap RegressionCheck::unchangedMap(const QString &path)
+{
+    // Identical files are not decoded for the check; the header gives the
+    // size, turned like the loader turns the pixels, and only formats Qt
+    // cannot size are decoded
+    QImageReader reader(path);
+    QSize size = reader.size();
+    if (reader.transformation() & QImageIOHandler::TransformationRotate90) {
+        size.transpose();
+    }
+    if (!size.isValid()) {
+        size = ImageLoader::load(path).size();
+    }
+    if (size.isEmpty()) return DiffMap();
+
+    const int blockSize = DiffMap::DEFAULT_BLOCK_SIZE;
+    const int blocks = ((size.width() + blockSize - 1) / blockSize) * ((size.height() + blockSize - 1) / blockSize);
+    return DiffMap::fromBlocks(size, blockSize, DiffMap::DEFAULT_THRESHOLD,
+                               QVector<quint8>(blocks, 0), QVector<DiffMap::Region>());
+}
+
+QString RegressionCheck::writeSidecar(const QString &firstPath, const QString &secondPath, const DiffMap &map,
+                                      const Options &options, qint64 differences, qint64 antiAliased)
+{
+    // Counts are only kept when they are perceptual and exact, which is what
+    // the viewer's difference mode shows
+    DiffSidecar::Metrics metrics;
+    if (options.perceptualThreshold >= 0.0) {
+        metrics.perceptualThreshold = options.perceptualThreshold;
+        metrics.includeAntiAliasing = options.includeAntiAliasing;
+        metrics.differentPixels = differences;
+        metrics.antiAliasedPixels = antiAliased;
+    }
+
+    const QString path = DiffSidecar::pathFor(secondPath);
+    if (!DiffSidecar::write(firstPath, secondPath, map, metrics)) {
+        return QString(", could not write diff map to %1").arg(path);
+    }
+    return QString(", diff map written to %1").arg(path);
+}
+
+QImage RegressionCheck::diffImage(const QImage &first, const QImage &second, int threshold)
+{
+    // Differences in red over a faded greyscale copy of the first image
+    QImage diff(first.size(), QImage::Format_RGB32);
+    for (int y = 0; y < first.height(); ++y) {
+        const QRgb *a = reinterpret_cast<const QRgb *>(first.constScanLine(y));
+        const QRgb *b = reinterpret_cast<const QRgb *>(second.constScanLine(y));
+        QRgb *out = reinterpret_cast<QRgb *>(diff.scanLine(y));
+        for (int x = 0; x < first.width(); ++x) {
+            if (pixelDiffers(a[x], b[x], threshold)) {
+                out[x] = qRgb(255, 0, 0);
+            } else {
+                const int gray = 192 + qGray(a[x]) / 4;
+                out[x] = qRgb(gray, gray, gray);
+            }
+        }
+    }
+    return diff;
+}
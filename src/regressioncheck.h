@@ -0,0 +1,58 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#ifndef REGRESSIONCHECK_H
+#define REGRESSIONCHECK_H
+
+#include <QImage>
+#include <QString>
+#include "diffmap.h"
+
+// Headless pass/fail comparison for CI visual-regression gates.
+//
+// The common pass case is kept cheap: byte-identical files pass without
+// decoding, and the tiled pixel compare stops as soon as the failure budget
+// is exceeded. A diff image is only written when the check fails. With a
+// perceptual threshold the PerceptualDiff kernel decides which pixels differ.
+// Optionally the pair's change map is saved as a sidecar, so reviewing the
+// result in the viewer afterwards needs no new analysis.
+class RegressionCheck
+{
+public:
+    enum ExitCode {
+        Pass = 0,
+        Fail = 1,
+        Error = 2
+    };
+
+    struct Options {
+        Options();
+
+        int threshold;              // per-channel difference tolerated, 0-255
+        double perceptualThreshold; // 0-1 YIQ tolerance, < 0 for the per-channel compare
+        bool includeAntiAliasing;   // perceptual only: count anti-aliased pixels as differences
+        qint64 maxDifferentPixels;  // failure budget in pixels
+        double maxDifferentRatio;   // failure budget as a fraction of all pixels, < 0 when unused
+        QString diffOutputPath;     // empty: <second>-diff.png next to the second image
+        bool writeSidecar;          // save the change map and counts for the viewer (DiffSidecar)
+    };
+
+    static ExitCode run(const QString &firstPath, const QString &secondPath,
+                        const Options &options, QString *message);
+
+private:
+    static bool filesIdentical(const QString &firstPath, const QString &secondPath);
+    static qint64 countDifferences(const QImage &first, const QImage &second,
+                                   int threshold, qint64 budget);
+    static DiffMap unchangedMap(const QString &path);
+    static QString writeSidecar(const QString &firstPath, const QString &secondPath, const DiffMap &map,
+                                const Options &options, qint64 differences, qint64 antiAliased);
+    static QImage diffImage(const QImage &first, const QImage &second, int threshold);
+
+    static const int TILE_SIZE = 256;
+};
+
+#endif // REGRESSIONCHECK_H
@@ -0,0 +1,324 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#include "resampler.h"
+#include <QVector>
+#include <QtConcurrent/QtConcurrentMap>
+#include <cmath>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Weights are fixed point with this many fractional bits; small enough that
+// they fit 16 bits and a full row of sums fits 32
+const int WEIGHT_BITS = 14;
+const int WEIGHT_ONE = 1 << WEIGHT_BITS;
+const int ROUNDING = 1 << (WEIGHT_BITS - 1);
+
+const double CUBIC_SUPPORT = 2.0;
+const int BAND_ROWS = 64;
+
+// Source taps for every output pixel along one axis
+struct Coefficients {
+    int taps;                 // stride of weights, at least the largest count
+    QVector<int> start;       // first source index per output index
+    QVector<int> count;
+    QVector<qint16> weights;
+};
+
+// Catmull-Rom, a = -0.5
+inline double cubic(double x)
+{
+    const double a = -0.5;
+    x = std::fabs(x);
+    if (x < 1.0) return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+    if (x < 2.0) return (((x - 5.0) * x + 8.0) * x - 4.0) * a;
+    return 0.0;
+}
+
+// Maps [offset, offset + span) of a sourceSize axis onto outSize pixels
+Coefficients coefficients(int offset, int span, int sourceSize, int outSize)
+{
+    const double scale = static_cast<double>(span) / outSize; // source pixels per output pixel
+    const bool downscale = scale > 1.0;
+
+    Coefficients c;
+    c.taps = downscale ? static_cast<int>(std::ceil(scale)) + 2
+                       : static_cast<int>(CUBIC_SUPPORT) * 2 + 1;
+    c.start.resize(outSize);
+    c.count.resize(outSize);
+    c.weights.fill(0, outSize * c.taps);
+
+    QVector<double> weights(c.taps);
+    for (int i = 0; i < outSize; ++i) {
+        const double center = offset + (i + 0.5) * scale;
+        int first;
+        int last;
+        if (downscale) {
+            // Exact overlap of each source pixel with the output pixel's span
+            const double low = center - scale / 2.0;
+            const double high = center + scale / 2.0;
+            first = qMax(0, static_cast<int>(std::floor(low)));
+            last = qMin(sourceSize, static_cast<int>(std::ceil(high)));
+            for (int x = first; x < last; ++x) {
+                weights[x - first] = qMin(x + 1.0, high) - qMax(static_cast<double>(x), low);
+            }
+        } else {
+            first = qMax(0, static_cast<int>(std::floor(center - CUBIC_SUPPORT)));
+            last = qMin(sourceSize, static_cast<int>(std::ceil(center + CUBIC_SUPPORT)));
+            for (int x = first; x < last; ++x) {
+                weights[x - first] = cubic(x + 0.5 - center);
+            }
+        }
+        const int count = qMin(last - first, c.taps);
+
+        double total = 0.0;
+        for (int t = 0; t < count; ++t) {
+            total += weights[t];
+        }
+
+        // Rounding leftovers go to the heaviest tap so flat areas stay flat
+        qint16 *fixed = c.weights.data() + i * c.taps;
+        int fixedTotal = 0;
+        int heaviest = 0;
+        for (int t = 0; t < count; ++t) {
+            fixed[t] = static_cast<qint16>(std::lround(weights[t] / total * WEIGHT_ONE));
+            fixedTotal += fixed[t];
+            if (fixed[t] > fixed[heaviest]) heaviest = t;
+        }
+        fixed[heaviest] = static_cast<qint16>(fixed[heaviest] + WEIGHT_ONE - fixedTotal);
+
+        c.start[i] = first;
+        c.count[i] = count;
+    }
+    return c;
+}
+
+inline uchar toByte(int sum)
+{
+    const int value = sum >> WEIGHT_BITS;
+    return static_cast<uchar>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+template <int Channels>
+void resampleRow(const uchar *in, uchar *out, const Coefficients &c)
+{
+    const int outSize = c.start.size();
+    for (int i = 0; i < outSize; ++i) {
+        const uchar *source = in + c.start[i] * Channels;
+        const qint16 *weight = c.weights.constData() + i * c.taps;
+        const int count = c.count[i];
+
+        int sum[Channels];
+        for (int ch = 0; ch < Channels; ++ch) {
+            sum[ch] = ROUNDING;
+        }
+        for (int t = 0; t < count; ++t) {
+            for (int ch = 0; ch < Channels; ++ch) {
+                sum[ch] += source[t * Channels + ch] * weight[t];
+            }
+        }
+        for (int ch = 0; ch < Channels; ++ch) {
+            out[i * Channels + ch] = toByte(sum[ch]);
+        }
+    }
+}
+
+#if defined(__SSE2__)
+// Four-channel rows, all channels of a pixel in one register. Taps are taken
+// in pairs, interleaved per channel, so one multiply-add applies both weights;
+// results are clamped like toByte by the saturating packs.
+void resampleRow4(const uchar *in, uchar *out, const Coefficients &c)
+{
+    const int outSize = c.start.size();
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rounding = _mm_set1_epi32(ROUNDING);
+    for (int i = 0; i < outSize; ++i) {
+        const uchar *source = in + c.start[i] * 4;
+        const qint16 *weight = c.weights.constData() + i * c.taps;
+        const int count = c.count[i];
+
+        __m128i sum = rounding;
+        int t = 0;
+        for (; t + 1 < count; t += 2) {
+            const __m128i pixels = _mm_unpacklo_epi8(
+                _mm_loadl_epi64(reinterpret_cast<const __m128i *>(source + t * 4)), zero);
+            const __m128i pairs = _mm_unpacklo_epi16(pixels, _mm_srli_si128(pixels, 8));
+            const quint32 weights = static_cast<quint16>(weight[t])
+                                    | (static_cast<quint32>(static_cast<quint16>(weight[t + 1])) << 16);
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(pairs, _mm_set1_epi32(static_cast<int>(weights))));
+        }
+        if (t < count) {
+            int raw;
+            std::memcpy(&raw, source + t * 4, sizeof(raw));
+            const __m128i pairs = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(raw), zero), zero);
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(pairs, _mm_set1_epi32(static_cast<quint16>(weight[t]))));
+        }
+
+        const __m128i values = _mm_srai_epi32(sum, WEIGHT_BITS);
+        const int pixel = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(values, values), zero));
+        std::memcpy(out + i * 4, &pixel, sizeof(pixel));
+    }
+}
+#endif
+
+// Plain contiguous loops over a whole row, which the compiler vectorizes
+void resampleColumns(const uchar *const *rows, const qint16 *weight, int count, int bytes, int *sum, uchar *out)
+{
+    for (int i = 0; i < bytes; ++i) {
+        sum[i] = ROUNDING;
+    }
+    for (int t = 0; t < count; ++t) {
+        const uchar *row = rows[t];
+        const int w = weight[t];
+        for (int i = 0; i < bytes; ++i) {
+            sum[i] += row[i] * w;
+        }
+    }
+    for (int i = 0; i < bytes; ++i) {
+        out[i] = toByte(sum[i]);
+    }
+}
+
+// Moves tap positions to a source that starts offset pixels in
+void shift(Coefficients *c, int offset)
+{
+    for (int &start : c->start) {
+        start -= offset;
+    }
+}
+
+// Runs function(top, bottom) over bands of rows, inline when there is only one
+template <typename Function>
+void forEachBand(int rows, Function function)
+{
+    const int bandCount = (rows + BAND_ROWS - 1) / BAND_ROWS;
+    if (bandCount <= 1) {
+        function(0, rows);
+        return;
+    }
+
+    QVector<int> bands(bandCount);
+    for (int i = 0; i < bandCount; ++i) {
+        bands[i] = i;
+    }
+    QtConcurrent::blockingMap(bands, [&](int band) {
+        function(band * BAND_ROWS, qMin(rows, (band + 1) * BAND_ROWS));
+    });
+}
+
+} // namespace
+
+QImage Resampler::scale(const QImage &image, const QSize &size, const QRect &sourceRect)
+{
+    const QRect area = sourceRect.isNull() ? image.rect() : sourceRect.intersected(image.rect());
+    if (image.isNull() || size.isEmpty() || area.isEmpty()) return QImage();
+
+    // Premultiplied so color does not bleed out of transparent pixels
+    QImage::Format format = image.format();
+    switch (format) {
+    case QImage::Format_Grayscale8:
+    case QImage::Format_RGB888:
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        break;
+    default:
+        format = image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
+        break;
+    }
+    if (area.size() == size) return image.copy(area).convertToFormat(format);
+
+    Coefficients horizontal = coefficients(area.left(), area.width(), image.width(), size.width());
+    Coefficients vertical = coefficients(area.top(), area.height(), image.height(), size.height());
+
+    // Source pixels the filter taps reach; tap windows only move forward
+    const QRect reach(QPoint(horizontal.start.first(), vertical.start.first()),
+                      QPoint(horizontal.start.last() + horizontal.count.last() - 1,
+                             vertical.start.last() + vertical.count.last() - 1));
+
+    // ARGB32 is premultiplied row by row as the horizontal pass reads it.
+    // Other formats are converted, but only the part the taps reach, so
+    // scaling one tile of a large image does not convert all of it.
+    const bool premultiplyRows = image.format() == QImage::Format_ARGB32;
+    QImage source = image;
+    if (!premultiplyRows && image.format() != format) {
+        source = image.copy(reach).convertToFormat(format);
+        shift(&horizontal, reach.left());
+        shift(&vertical, reach.top());
+    }
+    const int sourceLeft = horizontal.start.first();
+    const int sourceWidth = horizontal.start.last() + horizontal.count.last() - sourceLeft;
+    if (premultiplyRows) {
+        shift(&horizontal, sourceLeft);
+    }
+
+    // Horizontal pass over just the source rows the vertical taps reach
+    const int firstRow = vertical.start.first();
+    const int lastRow = vertical.start.last() + vertical.count.last();
+    QImage rows(size.width(), lastRow - firstRow, format);
+    if (rows.isNull()) return QImage();
+
+    const int channels = rows.depth() / 8;
+    forEachBand(rows.height(), [&](int top, int bottom) {
+        QVector<QRgb> premultiplied(premultiplyRows ? sourceWidth : 0);
+        for (int y = top; y < bottom; ++y) {
+            const uchar *in = source.constScanLine(firstRow + y);
+            if (premultiplyRows) {
+                const QRgb *pixels = reinterpret_cast<const QRgb *>(in) + sourceLeft;
+                for (int x = 0; x < sourceWidth; ++x) {
+                    premultiplied[x] = qPremultiply(pixels[x]);
+                }
+                in = reinterpret_cast<const uchar *>(premultiplied.constData());
+            }
+            uchar *out = rows.scanLine(y);
+            switch (channels) {
+            case 1: resampleRow<1>(in, out, horizontal); break;
+            case 3: resampleRow<3>(in, out, horizontal); break;
+#if defined(__SSE2__)
+            default: resampleRow4(in, out, horizontal); break;
+#else
+            default: resampleRow<4>(in, out, horizontal); break;
+#endif
+            }
+        }
+    });
+
+    QImage result(size, format);
+    if (result.isNull()) return QImage();
+    const int rowBytes = size.width() * channels;
+    const bool clampToAlpha = format == QImage::Format_ARGB32_Premultiplied
+                              && (area.width() < size.width() || area.height() < size.height());
+
+    forEachBand(size.height(), [&](int top, int bottom) {
+        QVector<int> sum(rowBytes);
+        QVector<const uchar *> taps(vertical.taps);
+        for (int y = top; y < bottom; ++y) {
+            const int count = vertical.count[y];
+            for (int t = 0; t < count; ++t) {
+                taps[t] = rows.constScanLine(vertical.start[y] - firstRow + t);
+            }
+            uchar *out = result.scanLine(y);
+            resampleColumns(taps.constData(), vertical.weights.constData() + y * vertical.taps,
+                            count, rowBytes, sum.data(), out);
+
+            // Bicubic overshoot can push a color past its alpha, which is not
+            // a valid premultiplied pixel
+            if (clampToAlpha) {
+                QRgb *pixels = reinterpret_cast<QRgb *>(out);
+                for (int x = 0; x < size.width(); ++x) {
+                    const int alpha = qAlpha(pixels[x]);
+                    pixels[x] = qRgba(qMin(qRed(pixels[x]), alpha), qMin(qGreen(pixels[x]), alpha),
+                                      qMin(qBlue(pixels[x]), alpha), alpha);
+                }
+            }
+        }
+    });
+
+    return result;
+}
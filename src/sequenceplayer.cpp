@@ -0,0 +1,302 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#include "sequenceplayer.h"
+#include "imageloader.h"
+#include <QMutexLocker>
+
+namespace {
+
+const double DEFAULT_FPS = 24.0;
+const double MAX_FPS = 240.0;
+
+} // namespace
+
+SequencePlayer::Decoder::Decoder()
+    : slotFrames(RING_CAPACITY, -1)
+    , slotImages(RING_CAPACITY)
+    , stopping(true)
+{
+}
+
+SequencePlayer::SequencePlayer(QObject *parent)
+    : QObject(parent)
+    , totalFrames(0)
+    , shownFrame(-1)
+    , playhead(0)
+    , clockStart(0)
+    , clockFrame(0)
+    , tickTimer(nullptr)
+    , fps(DEFAULT_FPS)
+    , playing(false)
+{
+    // One decode thread per side, kept off the global pool so tile work
+    // elsewhere is never starved by long-running decode loops
+    decodePool.setMaxThreadCount(2);
+
+    tickTimer = new QTimer(this);
+    tickTimer->setTimerType(Qt::PreciseTimer);
+    connect(tickTimer, &QTimer::timeout, this, &SequencePlayer::onTick);
+}
+
+SequencePlayer::~SequencePlayer()
+{
+    stopDecoders();
+}
+
+void SequencePlayer::setSequences(const ImageSequence &first, const ImageSequence &second)
+{
+    clear();
+
+    decoders[0].sequence = first;
+    decoders[1].sequence = second;
+    totalFrames = qMax(first.frameCount(), second.frameCount());
+    if (totalFrames == 0) return;
+
+    // Start where the opened file sits in its sequence
+    playhead = qBound(0, first.initialFrame(), totalFrames - 1);
+    shownFrame = -1;
+
+    for (Decoder &decoder : decoders) {
+        decoder.stopping = false;
+        Decoder *state = &decoder;
+        decodePool.start([this, state]() {
+            decodeLoop(this, state);
+        });
+    }
+    updateWindows();
+}
+
+void SequencePlayer::clear()
+{
+    pause();
+    stopDecoders();
+    for (Decoder &decoder : decoders) {
+        decoder.sequence = ImageSequence();
+    }
+    totalFrames = 0;
+    shownFrame = -1;
+    playhead = 0;
+}
+
+int SequencePlayer::frameCount() const
+{
+    return totalFrames;
+}
+
+int SequencePlayer::currentFrame() const
+{
+    return playhead;
+}
+
+bool SequencePlayer::isPlaying() const
+{
+    return playing;
+}
+
+double SequencePlayer::frameRate() const
+{
+    return fps;
+}
+
+void SequencePlayer::setFrameRate(double newFps)
+{
+    fps = qBound(1.0, newFps, MAX_FPS);
+    if (playing) {
+        // Restart the clock from the frame on screen so the rate change does not jump
+        clockStart = clockFrame;
+        clock.restart();
+        tickTimer->setInterval(qMax(1, static_cast<int>(500.0 / fps)));
+    }
+}
+
+void SequencePlayer::play()
+{
+    if (playing || totalFrames < 2) return;
+
+    playing = true;
+    clockStart = playhead;
+    clockFrame = playhead;
+    clock.start();
+    // Tick at twice the frame rate so a frame is never more than half a period late
+    tickTimer->start(qMax(1, static_cast<int>(500.0 / fps)));
+    emit playingChanged(true);
+}
+
+void SequencePlayer::pause()
+{
+    if (!playing) return;
+
+    playing = false;
+    tickTimer->stop();
+    emit playingChanged(false);
+
+    // Re-announce the frame on screen so listeners can do per-still work
+    // they skip during playback. The clock may have moved the decode window
+    // past it, so it is sought like any other frame and announced once decoded.
+    if (shownFrame < 0) return;
+    playhead = shownFrame;
+    shownFrame = -1;
+    updateWindows();
+    onFrameDecoded();
+}
+
+void SequencePlayer::seek(int frame)
+{
+    if (totalFrames == 0) return;
+
+    playhead = qBound(0, frame, totalFrames - 1);
+    shownFrame = -1;
+    if (playing) {
+        clockStart = playhead;
+        clockFrame = playhead - 1;
+        clock.restart();
+    }
+    updateWindows();
+    onFrameDecoded();
+}
+
+void SequencePlayer::onTick()
+{
+    if (!playing || totalFrames == 0) return;
+
+    const qint64 target = clockStart + static_cast<qint64>(clock.elapsed() * fps / 1000.0);
+    if (target <= clockFrame) return;
+
+    // Decode ahead of where the clock is now, not of the frame on screen, so
+    // a slow decoder skips frames instead of letting playback drift
+    const int targetFrame = static_cast<int>(target % totalFrames);
+    if (targetFrame != playhead) {
+        playhead = targetFrame;
+        updateWindows();
+    }
+
+    // Show the newest decoded frame the clock has reached
+    for (qint64 absolute = target; absolute > clockFrame; --absolute) {
+        const int frame = static_cast<int>(absolute % totalFrames);
+        QImage first;
+        QImage second;
+        if (takeFrame(frame, &first, &second)) {
+            clockFrame = absolute;
+            shownFrame = frame;
+            emit frameChanged(frame, first, second);
+            return;
+        }
+    }
+}
+
+void SequencePlayer::onFrameDecoded()
+{
+    // While playing the clock decides what to show
+    if (playing || totalFrames == 0 || shownFrame == playhead) return;
+
+    QImage first;
+    QImage second;
+    if (takeFrame(playhead, &first, &second)) {
+        shownFrame = playhead;
+        emit frameChanged(playhead, first, second);
+    }
+}
+
+int SequencePlayer::sideFrame(const Decoder &decoder, int frame) const
+{
+    return qMin(frame, decoder.sequence.frameCount() - 1);
+}
+
+void SequencePlayer::updateWindows()
+{
+    if (totalFrames == 0) return;
+
+    const int span = qMin(static_cast<int>(RING_CAPACITY), totalFrames);
+    for (Decoder &decoder : decoders) {
+        QVector<int> window;
+        for (int offset = 0; offset < span; ++offset) {
+            const int frame = sideFrame(decoder, (playhead + offset) % totalFrames);
+            if (!window.contains(frame)) {
+                window.append(frame);
+            }
+        }
+
+        QMutexLocker locker(&decoder.mutex);
+        decoder.window = window;
+        decoder.wanted.wakeAll();
+    }
+}
+
+bool SequencePlayer::takeFrame(int frame, QImage *first, QImage *second)
+{
+    QImage *images[2] = {first, second};
+    for (int side = 0; side < 2; ++side) {
+        Decoder &decoder = decoders[side];
+        QMutexLocker locker(&decoder.mutex);
+        const int slot = decoder.slotFrames.indexOf(sideFrame(decoder, frame));
+        if (slot < 0) return false;
+        *images[side] = decoder.slotImages.at(slot);
+    }
+    return true;
+}
+
+void SequencePlayer::decodeLoop(SequencePlayer *player, Decoder *decoder)
+{
+    // The sequence is fixed while the loop runs; setSequences stops it first
+    ImageSequence::Reader reader(decoder->sequence);
+
+    QMutexLocker locker(&decoder->mutex);
+    while (!decoder->stopping) {
+        // Most urgent frame in the window that no slot holds yet
+        int target = -1;
+        for (int frame : std::as_const(decoder->window)) {
+            if (!decoder->slotFrames.contains(frame)) {
+                target = frame;
+                break;
+            }
+        }
+        if (target < 0) {
+            decoder->wanted.wait(&decoder->mutex);
+            continue;
+        }
+
+        locker.unlock();
+        // Compacting here keeps both the ring and the GUI thread light
+        QImage image = ImageLoader::compact(reader.read(target));
+        locker.relock();
+
+        // The playhead may have moved on while decoding
+        if (!decoder->window.contains(target)) continue;
+
+        // Reuse a slot holding a frame the window no longer wants
+        int slot = -1;
+        for (int i = 0; i < decoder->slotFrames.size(); ++i) {
+            if (!decoder->window.contains(decoder->slotFrames.at(i))) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot < 0) continue;
+
+        decoder->slotFrames[slot] = target;
+        decoder->slotImages[slot] = image;
+        QMetaObject::invokeMethod(player, [player]() {
+            player->onFrameDecoded();
+        }, Qt::QueuedConnection);
+    }
+}
+
+void SequencePlayer::stopDecoders()
+{
+    for (Decoder &decoder : decoders) {
+        QMutexLocker locker(&decoder.mutex);
+        decoder.stopping = true;
+        decoder.wanted.wakeAll();
+    }
+    decodePool.waitForDone();
+
+    for (Decoder &decoder : decoders) {
+        decoder.window.clear();
+        decoder.slotFrames.fill(-1);
+        decoder.slotImages.fill(QImage());
+    }
+}
@@ -0,0 +1,91 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#ifndef SEQUENCEPLAYER_H
+#define SEQUENCEPLAYER_H
+
+#include <QObject>
+#include <QImage>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "imagesequence.h"
+
+// Plays two image sequences in lockstep. One worker thread per side decodes
+// into a small ring of frames ahead of the playhead; the playback clock picks
+// frames by elapsed time, skipping any that are not decoded in time, so the
+// frame rate holds even when decoding falls behind. A sequence shorter than
+// the other holds its last frame.
+class SequencePlayer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SequencePlayer(QObject *parent = nullptr);
+    ~SequencePlayer();
+
+    void setSequences(const ImageSequence &first, const ImageSequence &second);
+    void clear();
+
+    int frameCount() const;
+    int currentFrame() const;
+    bool isPlaying() const;
+    double frameRate() const;
+    void setFrameRate(double fps);
+
+public slots:
+    void play();
+    void pause();
+    void seek(int frame);
+
+signals:
+    // first and second are the decoded frames for both sides of frame
+    void frameChanged(int frame, const QImage &first, const QImage &second);
+    void playingChanged(bool playing);
+
+private slots:
+    void onTick();
+    void onFrameDecoded();
+
+private:
+    // Per-side decode state, shared with that side's worker under mutex
+    struct Decoder {
+        Decoder();
+
+        ImageSequence sequence;
+        QMutex mutex;
+        QWaitCondition wanted;       // signalled when the window moves or on stop
+        QVector<int> window;         // frames to hold, most urgent first
+        QVector<int> slotFrames;     // frame held by each ring slot, -1 when empty
+        QVector<QImage> slotImages;
+        bool stopping;
+    };
+
+    static void decodeLoop(SequencePlayer *player, Decoder *decoder);
+    void stopDecoders();
+    void updateWindows();
+    bool takeFrame(int frame, QImage *first, QImage *second);
+    int sideFrame(const Decoder &decoder, int frame) const;
+
+    Decoder decoders[2];
+    QThreadPool decodePool;
+    int totalFrames;
+    int shownFrame;      // frame last emitted, -1 while a seek is pending
+    int playhead;        // frame playback is at or waiting for
+    qint64 clockStart;   // absolute frame number at which the clock started
+    qint64 clockFrame;   // absolute frame number last shown while playing
+    QElapsedTimer clock;
+    QTimer *tickTimer;
+    double fps;
+    bool playing;
+
+    static const int RING_CAPACITY = 8; // decoded frames held per side
+};
+
+#endif // SEQUENCEPLAYER_H
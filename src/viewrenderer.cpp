@@ -0,0 +1,247 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#include "viewrenderer.h"
+#include "resampler.h"
+#include <QMutexLocker>
+
+ViewRenderer::ViewState::ViewState()
+    : base(FirstLayer)
+    , overlay(LayerCount)
+    , overlayOpacity(1.0)
+    , flip(LayerCount)
+{
+}
+
+bool ViewRenderer::ViewState::sameView(const ViewState &other) const
+{
+    if (size != other.size || base != other.base || overlay != other.overlay
+        || overlayClip != other.overlayClip || overlayOpacity != other.overlayOpacity
+        || flip != other.flip || revealEdge != other.revealEdge) {
+        return false;
+    }
+    for (int layer = 0; layer < LayerCount; ++layer) {
+        if (images[layer].cacheKey() != other.images[layer].cacheKey() || targets[layer] != other.targets[layer]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+ViewRenderer::ViewRenderer(QObject *parent)
+    : QObject(parent)
+    , pendingGeneration(0)
+    , stopping(false)
+    , frontHasFlip(false)
+    , frontGeneration(-1)
+    , latestGeneration(0)
+{
+    tiles.setMaxCost(TILE_CACHE_KB);
+    for (qint64 &source : tileSources) {
+        source = 0;
+    }
+    sinceFrame.start();
+
+    // Kept off the global pool, which the resampler uses for each tile
+    renderPool.setMaxThreadCount(1);
+    renderPool.start([this]() {
+        renderLoop(this);
+    });
+}
+
+ViewRenderer::~ViewRenderer()
+{
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        wanted.wakeAll();
+    }
+    renderPool.waitForDone();
+}
+
+int ViewRenderer::submit(const ViewState &state)
+{
+    if (latestGeneration.load() > 0 && state.sameView(submittedState)) {
+        return latestGeneration.load();
+    }
+    submittedState = state;
+
+    QMutexLocker locker(&mutex);
+    pendingState = state;
+    pendingGeneration = latestGeneration.fetch_add(1) + 1;
+    wanted.wakeAll();
+    return pendingGeneration;
+}
+
+int ViewRenderer::drawFrame(QPainter &painter, const QPoint &position, bool flipped, bool *showedFlip,
+                            ViewState *shownState)
+{
+    // Held only for the blit; the render thread takes it just to swap
+    QMutexLocker locker(&mutex);
+    const bool useFlip = flipped && frontHasFlip && !frontBuffer.isNull();
+    if (showedFlip) {
+        *showedFlip = useFlip;
+    }
+    if (shownState) {
+        *shownState = frontState;
+    }
+    if (frontBuffer.isNull()) return -1;
+    painter.drawImage(position, useFlip ? flipFrontBuffer : frontBuffer);
+    return frontGeneration;
+}
+
+void ViewRenderer::renderLoop(ViewRenderer *renderer)
+{
+    QMutexLocker locker(&renderer->mutex);
+    int renderedGeneration = 0;
+    while (!renderer->stopping) {
+        if (renderer->pendingGeneration == renderedGeneration) {
+            renderer->wanted.wait(&renderer->mutex);
+            continue;
+        }
+        const ViewState state = renderer->pendingState;
+        const int generation = renderer->pendingGeneration;
+        renderedGeneration = generation;
+
+        locker.unlock();
+        const bool complete = renderer->compose(state, generation, &renderer->backBuffer,
+                                                &renderer->flipBackBuffer);
+        ViewState shown = state;
+        for (QImage &image : shown.images) {
+            image = QImage();
+        }
+        locker.relock();
+        if (!complete) continue;
+
+        // The finished frames become the front buffers; the old fronts are
+        // reused for the next render
+        renderer->frontBuffer.swap(renderer->backBuffer);
+        renderer->frontHasFlip = state.flip != LayerCount;
+        if (renderer->frontHasFlip) {
+            renderer->flipFrontBuffer.swap(renderer->flipBackBuffer);
+        }
+        renderer->frontGeneration = generation;
+        renderer->frontState = shown;
+        renderer->sinceFrame.restart();
+        QMetaObject::invokeMethod(renderer, [renderer]() {
+            emit renderer->frameReady();
+        }, Qt::QueuedConnection);
+    }
+}
+
+void ViewRenderer::prepareBuffer(QImage *buffer, const QSize &size)
+{
+    if (buffer->size() != size) {
+        *buffer = QImage(size, QImage::Format_ARGB32_Premultiplied);
+    }
+    buffer->fill(Qt::transparent);
+}
+
+bool ViewRenderer::compose(const ViewState &state, int generation, QImage *buffer, QImage *flipBuffer)
+{
+    if (state.size.isEmpty()) return false;
+
+    prepareBuffer(buffer, state.size);
+    QPainter painter(buffer);
+    if (!drawTiles(painter, state.base, state, buffer->rect(), generation)) return false;
+
+    if (state.overlay != LayerCount && state.overlayOpacity > 0.0 && !state.overlayClip.isEmpty()) {
+        painter.setOpacity(state.overlayOpacity);
+        painter.setClipRect(state.overlayClip);
+        if (!drawTiles(painter, state.overlay, state, state.overlayClip, generation)) return false;
+    }
+
+    // The flip frame is finished with the main one, so either can be shown
+    // the moment the frame is swapped in
+    if (state.flip != LayerCount) {
+        prepareBuffer(flipBuffer, state.size);
+        QPainter flipPainter(flipBuffer);
+        if (!drawTiles(flipPainter, state.flip, state, flipBuffer->rect(), generation)) return false;
+    }
+    return true;
+}
+
+bool ViewRenderer::isStale(int generation) const
+{
+    return latestGeneration.load(std::memory_order_relaxed) != generation
+        && sinceFrame.elapsed() < MAX_STALE_MS;
+}
+
+bool ViewRenderer::drawTiles(QPainter &painter, Layer layer, const ViewState &state, const QRect &clip,
+                             int generation)
+{
+    const QImage &image = state.images[layer];
+    const QRect target = state.targets[layer];
+    const QRect visible = target.intersected(clip).intersected(QRect(QPoint(), state.size));
+    if (image.isNull() || visible.isEmpty()) return true;
+
+    // Cached tiles are only valid for the image and scale they were made from
+    if (tileTargets[layer] != target.size() || tileSources[layer] != image.cacheKey()) {
+        clearTiles(layer);
+        tileTargets[layer] = target.size();
+        tileSources[layer] = image.cacheKey();
+    }
+
+    // Source tiles come out roughly TILE_DISPLAY_SIZE on screen at any zoom
+    const double scaleX = static_cast<double>(target.width()) / image.width();
+    const double scaleY = static_cast<double>(target.height()) / image.height();
+    const int tileSize = qBound(MIN_SOURCE_TILE, static_cast<int>(TILE_DISPLAY_SIZE / scaleX), MAX_SOURCE_TILE);
+
+    const int firstColumn = qMax(0, static_cast<int>((visible.left() - target.left()) / scaleX) / tileSize);
+    const int lastColumn = qMin((image.width() - 1) / tileSize,
+                                static_cast<int>((visible.right() + 1 - target.left()) / scaleX) / tileSize);
+    const int firstRow = qMax(0, static_cast<int>((visible.top() - target.top()) / scaleY) / tileSize);
+    const int lastRow = qMin((image.height() - 1) / tileSize,
+                             static_cast<int>((visible.bottom() + 1 - target.top()) / scaleY) / tileSize);
+
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            const QRect source = QRect(column * tileSize, row * tileSize, tileSize, tileSize).intersected(image.rect());
+
+            // Neighbouring tiles share rounded edges, so they meet without gaps
+            const int left = target.left() + qRound(source.left() * scaleX);
+            const int right = target.left() + qRound((source.right() + 1) * scaleX);
+            const int top = target.top() + qRound(source.top() * scaleY);
+            const int bottom = target.top() + qRound((source.bottom() + 1) * scaleY);
+            if (right <= left || bottom <= top) continue;
+            const QRect dest(left, top, right - left, bottom - top);
+
+            const quint64 key = (static_cast<quint64>(layer) << 48) | (static_cast<quint64>(row) << 24)
+                              | static_cast<quint64>(column);
+            if (const QImage *cached = tiles.object(key)) {
+                painter.drawImage(dest.topLeft(), *cached);
+                continue;
+            }
+
+            // Only new tiles cost real time, so that is where a stale render stops
+            if (isStale(generation)) return false;
+
+            // Resampled in the stored format, so only the small result is converted
+            QImage tile = (source.size() == dest.size()) ? image.copy(source)
+                                                         : Resampler::scale(image, dest.size(), source);
+            tile = tile.convertToFormat(displayFormat(image));
+            painter.drawImage(dest.topLeft(), tile);
+            tiles.insert(key, new QImage(tile), static_cast<int>(tile.sizeInBytes() / 1024) + 1);
+        }
+    }
+    return true;
+}
+
+void ViewRenderer::clearTiles(Layer layer)
+{
+    const QList<quint64> keys = tiles.keys();
+    for (quint64 key : keys) {
+        if ((key >> 48) == static_cast<quint64>(layer)) {
+            tiles.remove(key);
+        }
+    }
+}
+
+QImage::Format ViewRenderer::displayFormat(const QImage &image)
+{
+    // Formats QPainter blits without conversion
+    return image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
+}
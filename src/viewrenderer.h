@@ -0,0 +1,123 @@
+//===========================================
+//  photo compare source code
+//  Copyright (c) 2025, jt(q5sys)
+//  Available under the MIT license
+//  See the LICENSE file for full details
+//===========================================
+#ifndef VIEWRENDERER_H
+#define VIEWRENDERER_H
+
+#include <QObject>
+#include <QImage>
+#include <QRect>
+#include <QLine>
+#include <QPainter>
+#include <QCache>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <atomic>
+
+// Composes the image layers of the compare view on a dedicated thread.
+//
+// The GUI thread describes the view in a ViewState and submits it; the render
+// thread draws it into the back one of two reusable frame buffers and swaps
+// it to the front when complete, so paintEvent only blits the front frame.
+// A render overtaken by a newer state is abandoned at the next tile, unless
+// nothing has completed for a while, so continuous input still shows frames.
+// Converted and resampled tiles are cached per layer until the layer's image
+// or on-screen size changes.
+//
+// A state may also name a flip layer, which is composed on its own into a
+// second frame alongside the main one. Both frames are swapped to the front
+// together, so the view can switch between them without a render.
+class ViewRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Layer {
+        FirstLayer,
+        SecondLayer,
+        DifferenceLayer,
+        LayerCount
+    };
+
+    // Everything a frame depends on, snapshotted on the GUI thread
+    struct ViewState {
+        ViewState();
+
+        bool sameView(const ViewState &other) const;
+
+        QSize size;
+        QImage images[LayerCount];
+        QRect targets[LayerCount];  // where each image lands on screen
+        Layer base;                 // drawn over the whole frame
+        Layer overlay;              // LayerCount when none
+        QRect overlayClip;
+        double overlayOpacity;
+        Layer flip;                 // composed alone into the flip frame, LayerCount when none
+        QLine revealEdge;           // not drawn here; kept so the view can draw it over this frame
+    };
+
+    explicit ViewRenderer(QObject *parent = nullptr);
+    ~ViewRenderer();
+
+    // Returns the generation of the submitted state; an unchanged view keeps
+    // the current generation and starts no render
+    int submit(const ViewState &state);
+
+    // Blits the latest completed frame and returns its generation, -1 when
+    // there is none yet. flipped blits the flip frame instead, when the
+    // frame has one; showedFlip tells whether it did. shownState receives
+    // the state the frame was composed from, without its images, so
+    // overlays can be drawn with the geometry that is on screen.
+    int drawFrame(QPainter &painter, const QPoint &position, bool flipped = false, bool *showedFlip = nullptr,
+                  ViewState *shownState = nullptr);
+
+signals:
+    void frameReady();
+
+private:
+    static void renderLoop(ViewRenderer *renderer);
+    bool compose(const ViewState &state, int generation, QImage *buffer, QImage *flipBuffer);
+    static void prepareBuffer(QImage *buffer, const QSize &size);
+    bool drawTiles(QPainter &painter, Layer layer, const ViewState &state, const QRect &clip, int generation);
+    bool isStale(int generation) const;
+    void clearTiles(Layer layer);
+    static QImage::Format displayFormat(const QImage &image);
+
+    // Shared with the render thread under mutex
+    QMutex mutex;
+    QWaitCondition wanted;
+    ViewState pendingState;
+    int pendingGeneration;
+    bool stopping;
+    QImage frontBuffer;
+    QImage flipFrontBuffer;
+    bool frontHasFlip;
+    int frontGeneration;
+    ViewState frontState;           // images dropped, so old frames pin no pixels
+
+    std::atomic<int> latestGeneration;
+    QThreadPool renderPool;
+
+    // Render thread only
+    QImage backBuffer;
+    QImage flipBackBuffer;
+    QCache<quint64, QImage> tiles;  // converted, resampled tiles; cost in KB
+    QSize tileTargets[LayerCount];  // on-screen size each layer's tiles were made for
+    qint64 tileSources[LayerCount]; // cacheKey of the image each layer's tiles came from
+    QElapsedTimer sinceFrame;
+
+    ViewState submittedState;       // GUI thread only
+
+    static const int TILE_DISPLAY_SIZE = 256; // on-screen tile edge the source tile size aims for
+    static const int MIN_SOURCE_TILE = 16;
+    static const int MAX_SOURCE_TILE = 1024;
+    static const int TILE_CACHE_KB = 96 * 1024;
+    static const int MAX_STALE_MS = 100; // renders older than this finish even when overtaken
+};
+
+#endif // VIEWRENDERER_H